@@ -0,0 +1,318 @@
+/*! @file benchmark.cpp
+    @brief Microbenchmark of the phases of Population::run()
+
+    Usage: `benchmark [--years=N] [--carrying_capacity=K,...]
+    [--overdispersion=k,...] [--pedigree_depth=d,...] [--seed=N] [--engine[=draws]]`
+
+    Each combination of the lists is run once from `0.2 * K` individuals,
+    and one TSV row per phase is written to stdout:
+    `carrying_capacity`, `overdispersion`, `pedigree_depth`, `phase`,
+    `individuals`, `seconds`, `ns_per_individual`, `allocations_per_individual`.
+    `individuals` is the sum of the census after reproduction over years,
+    or the number of rows for `write_sample_family`.
+    Allocations are counted by replacing the global `operator new`.
+
+    With `--engine[=draws]`, the random number engine chosen at build time
+    is timed and tested instead, and one TSV row per test is written:
+    `engine`, `test`, `draws`, `seconds`, `ns_per_draw`, `chi_square`, `df`.
+    `chi_square` follows the chi-squared distribution with `df` degrees of freedom
+    if the outputs are uniform; the `std_*` rows time the standard library
+    on the same engine for comparison.
+*/
+#include "population.hpp"
+#include "context.hpp"
+#include "profile.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> num_allocations{0u};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    ++num_allocations;
+    if (void* p = std::malloc(size ? size : 1u)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    ++num_allocations;
+    return std::malloc(size ? size : 1u);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete[](void* p) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::size_t) noexcept {std::free(p);}
+
+namespace {
+
+//! Settings given by command-line arguments
+struct Settings {
+    int years = 40;
+    uint64_t seed = 42u;
+    std::vector<double> carrying_capacity = {1e3, 1e4, 1e5};
+    std::vector<double> overdispersion = {-1.0, 1.0};
+    std::vector<int> pedigree_depth = {-1, 2};
+    uint64_t engine_draws = 0u;
+};
+
+//! Split comma-separated values
+template <class T>
+std::vector<T> split(const std::string& values) {
+    std::vector<T> result;
+    std::istringstream iss(values);
+    std::string field;
+    while (std::getline(iss, field, ',')) {
+        std::istringstream converter(field);
+        T x;
+        if (!(converter >> x)) throw std::runtime_error("invalid value: " + field);
+        result.push_back(x);
+    }
+    return result;
+}
+
+Settings parse(const std::vector<std::string>& args) {
+    Settings settings;
+    for (const auto& arg: args) {
+        const auto eq = arg.find('=');
+        const auto key = arg.substr(0u, eq);
+        const auto value = (eq == std::string::npos) ? std::string() : arg.substr(eq + 1u);
+        if (key == "--years") {
+            settings.years = std::stoi(value);
+        } else if (key == "--seed") {
+            settings.seed = std::stoull(value);
+        } else if (key == "--carrying_capacity") {
+            settings.carrying_capacity = split<double>(value);
+        } else if (key == "--overdispersion") {
+            settings.overdispersion = split<double>(value);
+        } else if (key == "--pedigree_depth") {
+            settings.pedigree_depth = split<int>(value);
+        } else if (key == "--engine") {
+            settings.engine_draws = value.empty() ? 10000000u : std::stoull(value);
+        } else {
+            throw std::runtime_error("unknown argument: " + arg);
+        }
+    }
+    return settings;
+}
+
+void write_row(std::ostream& ost, double carrying_capacity, double overdispersion, int depth,
+               const char* phase, uint64_t individuals, double seconds, uint64_t allocations) {
+    const double denominator = individuals ? static_cast<double>(individuals) : 1.0;
+    ost << carrying_capacity << "\t" << overdispersion << "\t" << depth << "\t"
+        << phase << "\t" << individuals << "\t" << seconds << "\t"
+        << seconds * 1e9 / denominator << "\t"
+        << static_cast<double>(allocations) / denominator << "\n";
+}
+
+void run(const Settings& settings, double carrying_capacity, double overdispersion, int depth) {
+    pbf::IndividualParams params;
+    params.CARRYING_CAPACITY = carrying_capacity;
+    params.NEGATIVE_BINOM_K = overdispersion;
+    auto context = std::make_shared<const pbf::Context>(params);
+    pbf::Population population(static_cast<size_t>(0.2 * carrying_capacity), settings.seed, context);
+    pbf::Profile profile([]{return num_allocations.load();});
+    population.set_profile(&profile);
+    uint64_t individuals = 0u;
+    population.set_demography_sink([&individuals](const pbf::Demography& census) {
+        if (census.season(0u) != 0) return;
+        for (size_t loc=0u; loc<census.num_locations(); ++loc) {
+            const auto counts = census.counts(0u, loc);
+            for (size_t age=0u; age<census.num_ages(); ++age) individuals += counts[age];
+        }
+    });
+    population.run(settings.years, {100u, 100u}, {100u, 100u}, 3, depth);
+    population.set_profile(nullptr);
+    population.set_demography_sink(nullptr);
+
+    for (const auto phase: {pbf::Profile::Phase::reproduce, pbf::Profile::Phase::survive,
+                            pbf::Profile::Phase::sample, pbf::Profile::Phase::migrate,
+                            pbf::Profile::Phase::census}) {
+        write_row(std::cout, carrying_capacity, overdispersion, depth, pbf::Profile::name(phase),
+                  individuals, profile.seconds(phase), profile.probed(phase));
+    }
+
+    std::ostringstream sink;
+    const uint64_t allocations = num_allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    population.write_sample_family(sink);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const std::string output = sink.str();
+    uint64_t rows = 0u;
+    for (const char c: output) rows += (c == '\n');
+    write_row(std::cout, carrying_capacity, overdispersion, depth, "write_sample_family",
+              rows ? rows - 1u : 0u, elapsed.count(), num_allocations.load() - allocations);
+}
+
+//! Chi-squared statistic of counts against equal expectations
+double chi_square(const std::vector<uint64_t>& counts, double expected) {
+    double x = 0.0;
+    for (const auto c: counts) {
+        const double d = static_cast<double>(c) - expected;
+        x += d * d / expected;
+    }
+    return x;
+}
+
+//! Sum of squared z-scores of the number of ones at each bit
+double bit_balance(const std::vector<uint64_t>& ones, uint64_t draws) {
+    const double n = static_cast<double>(draws);
+    double x = 0.0;
+    for (const auto c: ones) {
+        const double z = (static_cast<double>(c) - 0.5 * n) / std::sqrt(0.25 * n);
+        x += z * z;
+    }
+    return x;
+}
+
+void count_bits(uint64_t x, std::vector<uint64_t>* ones) noexcept {
+    for (unsigned b=0u; b<64u; ++b) (*ones)[b] += (x >> b) & 1u;
+}
+
+//! Wall time of `draws` calls of `draw`
+template <class Function>
+std::chrono::duration<double> time_draws(uint64_t draws, Function draw) {
+    volatile uint64_t sink = 0u;
+    uint64_t x = 0u;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i=0u; i<draws; ++i) x ^= static_cast<uint64_t>(draw());
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = x;
+    static_cast<void>(sink);
+    return elapsed;
+}
+
+//! Time and test the engine
+void run_engine(const Settings& settings) {
+    const uint64_t draws = settings.engine_draws;
+    std::cout << "engine\ttest\tdraws\tseconds\tns_per_draw\tchi_square\tdf\n";
+    auto write = [draws](const char* test, std::chrono::duration<double> elapsed,
+                         double statistic, unsigned df) {
+        std::cout << pbf::URBG::name() << "\t" << test << "\t" << draws << "\t"
+                  << elapsed.count() << "\t" << elapsed.count() * 1e9 / static_cast<double>(draws) << "\t"
+                  << statistic << "\t" << df << "\n";
+    };
+    constexpr unsigned num_bins = 100u;
+    const double expected = static_cast<double>(draws) / num_bins;
+    {
+        pbf::URBG engine(settings.seed);
+        const auto elapsed = time_draws(draws, [&engine] {return engine();});
+        engine = pbf::URBG(settings.seed);
+        std::vector<uint64_t> ones(64u);
+        for (uint64_t i=0u; i<draws; ++i) count_bits(engine(), &ones);
+        write("next", elapsed, bit_balance(ones, draws), 64u);
+    }
+    {
+        pbf::URBG engine(settings.seed);
+        std::vector<pbf::URBG::result_type> buffer(1024u);
+        size_t position = buffer.size();
+        const auto elapsed = time_draws(draws, [&] {
+            if (position == buffer.size()) {
+                engine.generate(buffer.data(), buffer.size());
+                position = 0u;
+            }
+            return buffer[position++];
+        });
+        engine = pbf::URBG(settings.seed);
+        std::vector<uint64_t> ones(64u);
+        for (uint64_t i=0u; i<draws; i+=buffer.size()) {
+            const auto n = static_cast<size_t>(std::min<uint64_t>(buffer.size(), draws - i));
+            engine.generate(buffer.data(), n);
+            for (size_t j=0u; j<n; ++j) count_bits(buffer[j], &ones);
+        }
+        write("generate", elapsed, bit_balance(ones, draws), 64u);
+    }
+    {
+        // adjacent streams must not be correlated
+        uint32_t index = 0u;
+        const auto elapsed = time_draws(draws, [&] {
+            return pbf::URBG(settings.seed, index++, 0u, 0u)();
+        });
+        std::vector<uint64_t> ones(64u);
+        for (uint64_t i=0u; i<draws; ++i) {
+            const auto j = static_cast<uint32_t>(i);
+            pbf::URBG a(settings.seed, j, 0u, 0u), b(settings.seed, j + 1u, 0u, 0u);
+            count_bits(a() ^ b(), &ones);
+        }
+        write("streams", elapsed, bit_balance(ones, draws), 64u);
+    }
+    {
+        pbf::URBG engine(settings.seed);
+        const auto elapsed = time_draws(draws, [&engine] {return pbf::canonical(engine) * num_bins;});
+        std::vector<uint64_t> counts(num_bins);
+        for (uint64_t i=0u; i<draws; ++i) ++counts[static_cast<size_t>(pbf::canonical(engine) * num_bins)];
+        write("canonical", elapsed, chi_square(counts, expected), num_bins - 1u);
+    }
+    {
+        pbf::URBG engine(settings.seed);
+        const auto elapsed = time_draws(draws, [&engine] {
+            return std::generate_canonical<double, 53>(engine) * num_bins;
+        });
+        std::vector<uint64_t> counts(num_bins);
+        for (uint64_t i=0u; i<draws; ++i) {
+            ++counts[static_cast<size_t>(std::generate_canonical<double, 53>(engine) * num_bins)];
+        }
+        write("std_canonical", elapsed, chi_square(counts, expected), num_bins - 1u);
+    }
+    {
+        pbf::URBG engine(settings.seed);
+        const auto elapsed = time_draws(draws, [&engine] {return pbf::bounded(engine, num_bins);});
+        std::vector<uint64_t> counts(num_bins);
+        for (uint64_t i=0u; i<draws; ++i) ++counts[pbf::bounded(engine, num_bins)];
+        write("bounded", elapsed, chi_square(counts, expected), num_bins - 1u);
+    }
+    {
+        pbf::URBG engine(settings.seed);
+        std::uniform_int_distribution<size_t> uniform(0u, num_bins - 1u);
+        const auto elapsed = time_draws(draws, [&] {return uniform(engine);});
+        std::vector<uint64_t> counts(num_bins);
+        for (uint64_t i=0u; i<draws; ++i) ++counts[uniform(engine)];
+        write("std_bounded", elapsed, chi_square(counts, expected), num_bins - 1u);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const Settings settings = parse(std::vector<std::string>(argv + 1, argv + argc));
+        if (settings.engine_draws > 0u) {
+            run_engine(settings);
+            return EXIT_SUCCESS;
+        }
+        std::cout << "carrying_capacity\toverdispersion\tpedigree_depth\tphase\t"
+                  << "individuals\tseconds\tns_per_individual\tallocations_per_individual\n";
+        for (const auto k: settings.carrying_capacity) {
+            for (const auto overdispersion: settings.overdispersion) {
+                for (const auto depth: settings.pedigree_depth) {
+                    run(settings, k, overdispersion, depth);
+                    std::cout.flush();
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
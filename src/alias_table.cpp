@@ -0,0 +1,78 @@
+/*! @file alias_table.cpp
+    @brief Implementation of AliasTable class
+*/
+#include "alias_table.hpp"
+
+#include <numeric>
+#include <stdexcept>
+
+namespace pbf {
+
+constexpr AliasTables::result_type AliasTables::NONE;
+
+AliasTable::AliasTable(std::vector<double> weights)
+: probability_(std::move(weights)),
+  alias_(probability_.size()),
+  size_(static_cast<double>(probability_.size())),
+  last_(static_cast<result_type>(probability_.size() - 1u)) {
+    if (probability_.empty()) {
+        throw std::invalid_argument("AliasTable: empty weights");
+    }
+    build(probability_.data(), alias_.data(), probability_.size());
+}
+
+void AliasTable::build(double* probability, result_type* alias, const size_t n) {
+    const double total = std::accumulate(probability, probability + n, 0.0);
+    const double scale = (total > 0.0) ? static_cast<double>(n) / total : 0.0;
+    std::vector<result_type> small, large;
+    for (result_type i=0u; i<n; ++i) {
+        alias[i] = i;
+        if (total > 0.0) {
+            probability[i] *= scale;
+        } else {
+            probability[i] = 1.0;
+        }
+        if (probability[i] < 1.0) {
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+    while (!small.empty() && !large.empty()) {
+        const result_type s = small.back();
+        small.pop_back();
+        const result_type l = large.back();
+        alias[s] = l;
+        probability[l] -= 1.0 - probability[s];
+        if (probability[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // leftovers are 1.0 except for rounding errors
+    for (const auto i: small) probability[i] = 1.0;
+    for (const auto i: large) probability[i] = 1.0;
+}
+
+void AliasTables::push_back(const std::vector<double>& weights) {
+    if (weights.size() != num_categories_ || weights.empty()) {
+        throw std::invalid_argument("AliasTables: wrong number of weights");
+    }
+    const size_t offset = probability_.size();
+    probability_.insert(probability_.end(), weights.begin(), weights.end());
+    alias_.resize(offset + num_categories_);
+    AliasTable::build(probability_.data() + offset, alias_.data() + offset, num_categories_);
+    const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+    result_type fixed = NONE;
+    unsigned num_positive = 0u;
+    for (result_type i=0u; i<num_categories_; ++i) {
+        weights_.push_back(total > 0.0 ? weights[i] / total : 1.0 / size_);
+        if (weights[i] > 0.0) {
+            ++num_positive;
+            fixed = i;
+        }
+    }
+    constant_.push_back(num_positive == 1u ? fixed : NONE);
+}
+
+} // namespace pbf
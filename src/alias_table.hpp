@@ -0,0 +1,128 @@
+/*! @file alias_table.hpp
+    @brief Interface of AliasTable class
+*/
+#pragma once
+#ifndef PBT_ALIAS_TABLE_HPP_
+#define PBT_ALIAS_TABLE_HPP_
+
+#include "random.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Weighted sampler in constant time by Walker's alias method
+
+    A drop-in replacement of `std::discrete_distribution<uint_fast32_t>`
+    for repeated draws from fixed weights.
+    Construction (Vose's algorithm) is \f$O(n)\f$,
+    and each draw costs a single call of the engine.
+*/
+class AliasTable {
+  public:
+    //! Alias
+    using result_type = uint_fast32_t;
+    //! construct from weights; uniform if all weights are zero
+    template <class InputIterator>
+    AliasTable(InputIterator first, InputIterator last)
+    : AliasTable(std::vector<double>(first, last)) {}
+    //! construct from weights; uniform if all weights are zero
+    explicit AliasTable(std::vector<double> weights);
+
+    //! draw an index
+    template <class URBG>
+    result_type operator()(URBG& engine) const {
+        const double x = canonical(engine) * size_;
+        const auto i = std::min(static_cast<result_type>(x), last_);
+        return (x - static_cast<double>(i) < probability_[i]) ? i : alias_[i];
+    }
+
+    //! number of categories
+    size_t size() const noexcept {return probability_.size();}
+
+    //! replace `n` weights in place with a table of `probability` and `alias`
+    static void build(double* probability, result_type* alias, size_t n);
+
+  private:
+    //! probability to keep the column
+    std::vector<double> probability_;
+    //! alternative index for each column
+    std::vector<result_type> alias_;
+    //! size() as double
+    double size_;
+    //! size() - 1
+    result_type last_;
+};
+
+/*! @brief Alias tables of the same number of categories in flat arrays
+
+    Rows are drawn in constant time without indirect calls,
+    and a row with a single positive weight returns its index
+    without consuming the engine.
+    The same draws as AliasTable are made from the same weights otherwise.
+    Normalized weights are kept for multinomial draws.
+*/
+class AliasTables {
+  public:
+    //! Alias
+    using result_type = AliasTable::result_type;
+    //! construct empty tables of `num_categories` columns
+    explicit AliasTables(size_t num_categories=0u) noexcept
+    : num_categories_(num_categories),
+      size_(static_cast<double>(num_categories)),
+      last_(num_categories ? static_cast<result_type>(num_categories - 1u) : 0u) {}
+
+    //! append a row of weights; uniform if all weights are zero
+    void push_back(const std::vector<double>& weights);
+
+    //! draw an index from a row
+    template <class URBG>
+    result_type operator()(size_t row, URBG& engine) const {
+        const result_type fixed = constant_[row];
+        if (fixed != NONE) return fixed;
+        const size_t offset = row * num_categories_;
+        const double x = canonical(engine) * size_;
+        const auto i = std::min(static_cast<result_type>(x), last_);
+        return (x - static_cast<double>(i) < probability_[offset + i]) ? i : alias_[offset + i];
+    }
+
+    //! normalized weights of a row
+    const double* weights(size_t row) const noexcept {
+        return weights_.data() + row * num_categories_;
+    }
+    //! the only possible index of a row if any, or NONE
+    result_type constant(size_t row) const noexcept {return constant_[row];}
+    //! number of rows
+    size_t size() const noexcept {return constant_.size();}
+    //! number of categories
+    size_t num_categories() const noexcept {return num_categories_;}
+
+    //! Value of constant() for rows with multiple choices
+    static constexpr result_type NONE = std::numeric_limits<result_type>::max();
+
+  private:
+    //! [row][category] probability to keep the column
+    std::vector<double> probability_;
+    //! [row][category] alternative index for each column
+    std::vector<result_type> alias_;
+    //! [row][category] normalized weights
+    std::vector<double> weights_;
+    //! [row] the only possible index or NONE
+    std::vector<result_type> constant_;
+    //! number of columns
+    size_t num_categories_;
+    //! #num_categories_ as double
+    double size_;
+    //! #num_categories_ - 1
+    result_type last_;
+};
+
+} // namespace pbf
+
+#endif /* PBT_ALIAS_TABLE_HPP_ */
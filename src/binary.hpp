@@ -0,0 +1,140 @@
+/*! @file binary.hpp
+    @brief Little-endian I/O of fixed-width integers
+*/
+#pragma once
+#ifndef PBT_BINARY_HPP_
+#define PBT_BINARY_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+namespace binary {
+
+//! true if the host stores integers in little-endian
+inline bool is_little_endian() noexcept {
+    const uint16_t probe = 1u;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1u);
+    return first == 1u;
+}
+
+//! write `n` integers in little-endian
+template <class T> inline
+void write(std::ostream& ost, const T* data, size_t n) {
+    static_assert(std::is_integral<T>{}, "");
+    if (is_little_endian()) {
+        ost.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(n * sizeof(T)));
+        return;
+    }
+    for (size_t i=0; i<n; ++i) {
+        const auto x = static_cast<typename std::make_unsigned<T>::type>(data[i]);
+        char bytes[sizeof(T)];
+        for (size_t j=0; j<sizeof(T); ++j) {
+            bytes[j] = static_cast<char>((x >> (8u * j)) & 0xFFu);
+        }
+        ost.write(bytes, sizeof(T));
+    }
+}
+
+//! write an integer in little-endian
+template <class T> inline
+void write(std::ostream& ost, const T x) {
+    write(ost, &x, 1u);
+}
+
+//! read `n` integers in little-endian
+template <class T> inline
+void read(std::istream& ist, T* data, size_t n) {
+    static_assert(std::is_integral<T>{}, "");
+    ist.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(n * sizeof(T)));
+    if (!ist) throw std::runtime_error("unexpected end of binary input");
+    if (is_little_endian()) return;
+    for (size_t i=0; i<n; ++i) {
+        unsigned char bytes[sizeof(T)];
+        std::memcpy(bytes, data + i, sizeof(T));
+        typename std::make_unsigned<T>::type x = 0u;
+        for (size_t j=0; j<sizeof(T); ++j) {
+            x |= static_cast<decltype(x)>(bytes[j]) << (8u * j);
+        }
+        data[i] = static_cast<T>(x);
+    }
+}
+
+//! read an integer in little-endian
+template <class T> inline
+T read(std::istream& ist) {
+    T x;
+    read(ist, &x, 1u);
+    return x;
+}
+
+//! write the length and elements of a vector of integers
+template <class T> inline
+void write_vector(std::ostream& ost, const std::vector<T>& v) {
+    write(ost, static_cast<uint64_t>(v.size()));
+    write(ost, v.data(), v.size());
+}
+
+//! read a vector written by write_vector()
+template <class T> inline
+void read_vector(std::istream& ist, std::vector<T>* v) {
+    v->resize(static_cast<size_t>(read<uint64_t>(ist)));
+    read(ist, v->data(), v->size());
+}
+
+//! write a double by its bit pattern
+inline void write_double(std::ostream& ost, const double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    write(ost, bits);
+}
+
+//! read a double written by write_double()
+inline double read_double(std::istream& ist) {
+    const auto bits = read<uint64_t>(ist);
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+//! write a string with its length
+inline void write_string(std::ostream& ost, const std::string& s) {
+    write(ost, static_cast<uint64_t>(s.size()));
+    ost.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+//! read a string written by write_string()
+inline std::string read_string(std::istream& ist) {
+    std::string s(static_cast<size_t>(read<uint64_t>(ist)), '\0');
+    ist.read(&s[0], static_cast<std::streamsize>(s.size()));
+    if (!ist) throw std::runtime_error("unexpected end of binary input");
+    return s;
+}
+
+//! write a fixed-length tag
+inline void write_magic(std::ostream& ost, const char (&magic)[9]) {
+    ost.write(magic, 8);
+}
+
+//! read and check a fixed-length tag
+inline void read_magic(std::istream& ist, const char (&magic)[9]) {
+    char buffer[8];
+    ist.read(buffer, 8);
+    if (!ist || std::memcmp(buffer, magic, 8u) != 0) {
+        throw std::runtime_error(std::string("not a file of ") + magic);
+    }
+}
+
+} // namespace binary
+} // namespace pbf
+
+#endif /* PBT_BINARY_HPP_ */
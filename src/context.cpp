@@ -0,0 +1,54 @@
+/*! @file context.cpp
+    @brief Implementation of Context class
+*/
+#include "context.hpp"
+
+#include <wtl/random.hpp>
+
+namespace pbf {
+
+Context::Context(const IndividualParams& params, std::istream& json)
+: params_(params) {
+    json_.read(json);
+}
+
+bool Context::is_dead_at(const int_fast32_t age, URBG& engine) const {
+    return (engine() >> 11) < json_.DEATH_THRESHOLD[age];
+}
+
+uint_fast32_t Context::recruitment_at(const int_fast32_t age, const double density_effect, URBG& engine) const noexcept {
+    if (density_effect < 0.0) return 0u;
+    return recruitment(recruitment_factor(density_effect) * weight_at(age), engine);
+}
+
+uint_fast32_t Context::recruitment(const double mean, URBG& engine) const noexcept {
+    const double k = params_.NEGATIVE_BINOM_K;
+    if (k > 0.0) {
+        const double prob = k / (mean + k);
+        return wtl::negative_binomial_distribution<uint_fast32_t>(k, prob)(engine);
+    } else {
+        return std::poisson_distribution<uint_fast32_t>(mean)(engine);
+    }
+}
+
+uint_fast32_t Context::recruitment_at(const int_fast32_t age, const uint_fast32_t num_mothers,
+                                     const double density_effect, URBG& engine) const {
+    if (density_effect <= 0.0 || num_mothers == 0u) return 0u;
+    const double mean = density_effect * params_.RECRUITMENT_COEF * weight_at(age);
+    if (mean <= 0.0) return 0u;
+    const double k = params_.NEGATIVE_BINOM_K;
+    if (k > 0.0) {
+        // sum of iid NB(k, p) is NB(n k, p)
+        const double prob = k / (mean + k);
+        return wtl::negative_binomial_distribution<uint_fast32_t>(k * num_mothers, prob)(engine);
+    } else {
+        return std::poisson_distribution<uint_fast32_t>(mean * num_mothers)(engine);
+    }
+}
+
+uint_fast32_t Context::migrate_at(const uint_fast32_t loc, const int_fast32_t age, URBG& engine) const {
+    const auto& table = json_.MIGRATION_DISTRIBUTIONS;
+    return table(static_cast<size_t>(age) * table.num_categories() + loc, engine);
+}
+
+} // namespace pbf
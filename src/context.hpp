@@ -0,0 +1,86 @@
+/*! @file context.hpp
+    @brief Interface of Context class
+*/
+#pragma once
+#ifndef PBT_CONTEXT_HPP_
+#define PBT_CONTEXT_HPP_
+
+#include "individual.hpp"
+#include "random_fwd.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Parameters and precomputed tables of a run
+
+    Population refers to a Context through `std::shared_ptr<const Context>`,
+    so that runs with different settings can coexist in a process
+    and the tables are built once for any number of replicates.
+    All the member functions are const and safe to call from multiple threads.
+*/
+class Context {
+  public:
+    //! default parameters
+    Context() = default;
+    //! with default JSON parameters
+    explicit Context(const IndividualParams& params): params_(params) {}
+    //! with JSON parameters read from stream; missing keys keep default values
+    Context(const IndividualParams& params, std::istream& json);
+
+    //! @name Functions of age
+    //@{
+    //! evaluate survival
+    bool is_dead_at(int_fast32_t age, URBG&) const;
+    //! number of juveniles
+    uint_fast32_t recruitment_at(int_fast32_t age, double density_effect, URBG&) const noexcept;
+    //! number of juveniles from a mother with precomputed mean; see recruitment_factor()
+    uint_fast32_t recruitment(double mean, URBG&) const noexcept;
+    //! mean recruitment per unit weight; negative if no recruitment
+    double recruitment_factor(double density_effect) const noexcept {
+        return density_effect * params_.RECRUITMENT_COEF;
+    }
+    //! total number of juveniles from `num_mothers` of the same age in a single draw
+    uint_fast32_t recruitment_at(int_fast32_t age, uint_fast32_t num_mothers,
+                                 double density_effect, URBG&) const;
+    //! return new location
+    uint_fast32_t migrate_at(uint_fast32_t loc, int_fast32_t age, URBG&) const;
+    //! IndividualJson.WEIGHT_FOR_YEAR_AGE
+    double weight_at(int_fast32_t age) const noexcept {
+        return json_.WEIGHT_FOR_YEAR_AGE[age];
+    }
+    //@}
+
+    //! Write JSON parameters
+    void write_json(std::ostream& ost) const {json_.write(ost);}
+
+    //! @name Getter functions
+    //@{
+    //! #params_
+    const IndividualParams& param() const noexcept {return params_;}
+    //! #json_
+    const IndividualJson& json() const noexcept {return json_;}
+    //! IndividualJson.DEATH_RATE
+    const std::vector<double>& death_rate() const noexcept {return json_.DEATH_RATE;}
+    //! IndividualJson.DEATH_THRESHOLD
+    const std::vector<uint64_t>& death_threshold() const noexcept {return json_.DEATH_THRESHOLD;}
+    //! IndividualJson.WEIGHT_FOR_YEAR_AGE
+    const std::vector<double>& weight_for_age() const noexcept {return json_.WEIGHT_FOR_YEAR_AGE;}
+    //! IndividualJson.MIGRATION_DISTRIBUTIONS
+    const AliasTables& migration() const noexcept {return json_.MIGRATION_DISTRIBUTIONS;}
+    //@}
+
+  private:
+    //! Parameters from command-line
+    IndividualParams params_;
+    //! Parameters from JSON file
+    IndividualJson json_;
+};
+
+} // namespace pbf
+
+#endif /* PBT_CONTEXT_HPP_ */
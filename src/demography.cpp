@@ -0,0 +1,104 @@
+/*! @file demography.cpp
+    @brief Implementation of Demography class
+*/
+#include "demography.hpp"
+#include "binary.hpp"
+
+#include <ostream>
+#include <istream>
+#include <string>
+
+namespace pbf {
+
+namespace {
+
+//! Tag at the beginning of binary files
+constexpr char MAGIC[9] = "PBTDEMOG";
+//! Version of the binary format
+constexpr uint32_t VERSION = 1u;
+
+//! Append decimal digits and a delimiter to `buffer`
+inline void append_field(std::string* buffer, uint64_t x, const char delimiter) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = static_cast<char>('0' + x % 10u);
+        x /= 10u;
+    } while (x > 0u);
+    buffer->append(p, digits + sizeof(digits));
+    buffer->push_back(delimiter);
+}
+
+//! Append decimal digits with sign and a delimiter to `buffer`
+inline void append_field(std::string* buffer, int64_t x, const char delimiter) {
+    if (x < 0) {
+        buffer->push_back('-');
+        append_field(buffer, static_cast<uint64_t>(-x), delimiter);
+    } else {
+        append_field(buffer, static_cast<uint64_t>(x), delimiter);
+    }
+}
+
+} // namespace
+
+Demography::count_type* Demography::append(const int_fast32_t year, const int_fast32_t season) {
+    times_.push_back(static_cast<int32_t>(year));
+    times_.push_back(static_cast<int32_t>(season));
+    const size_t slice = num_locations_ * num_ages_;
+    counts_.resize(counts_.size() + slice, 0u);
+    return counts_.data() + counts_.size() - slice;
+}
+
+std::ostream& Demography::write_header(std::ostream& ost) {
+    return ost << "year\tseason\tlocation\tage\tcount\n";
+}
+
+std::ostream& Demography::write(std::ostream& ost, const bool header) const {
+    if (header) write_header(ost);
+    std::string buffer;
+    for (size_t t=0u; t<num_times(); ++t) {
+        for (size_t loc=0u; loc<num_locations_; ++loc) {
+            const count_type* structure = counts(t, loc);
+            for (size_t age=0u; age<num_ages_; ++age) {
+                if (structure[age] == 0u) continue;
+                append_field(&buffer, int64_t{year(t)}, '\t');
+                append_field(&buffer, int64_t{season(t)}, '\t');
+                append_field(&buffer, uint64_t{loc}, '\t');
+                append_field(&buffer, uint64_t{age}, '\t');
+                append_field(&buffer, uint64_t{structure[age]}, '\n');
+            }
+        }
+        ost << buffer;
+        buffer.clear();
+    }
+    return ost;
+}
+
+std::ostream& Demography::write_binary(std::ostream& ost) const {
+    binary::write_magic(ost, MAGIC);
+    binary::write(ost, VERSION);
+    binary::write(ost, static_cast<uint32_t>(num_times()));
+    binary::write(ost, static_cast<uint32_t>(num_locations_));
+    binary::write(ost, static_cast<uint32_t>(num_ages_));
+    binary::write(ost, times_.data(), times_.size());
+    binary::write(ost, counts_.data(), counts_.size());
+    return ost;
+}
+
+Demography Demography::read_binary(std::istream& ist) {
+    binary::read_magic(ist, MAGIC);
+    if (binary::read<uint32_t>(ist) != VERSION) {
+        throw std::runtime_error("unsupported version of demography");
+    }
+    const size_t num_times = binary::read<uint32_t>(ist);
+    const size_t num_locations = binary::read<uint32_t>(ist);
+    const size_t num_ages = binary::read<uint32_t>(ist);
+    Demography demography(num_locations, num_ages);
+    demography.times_.resize(2u * num_times);
+    demography.counts_.resize(num_times * num_locations * num_ages);
+    binary::read(ist, demography.times_.data(), demography.times_.size());
+    binary::read(ist, demography.counts_.data(), demography.counts_.size());
+    return demography;
+}
+
+} // namespace pbf
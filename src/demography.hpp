@@ -0,0 +1,81 @@
+/*! @file demography.hpp
+    @brief Interface of Demography class
+*/
+#pragma once
+#ifndef PBT_DEMOGRAPHY_HPP_
+#define PBT_DEMOGRAPHY_HPP_
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Census counts in a contiguous (time, location, age) array
+
+    Each census is identified by (year, season) in the order of append().
+
+    The binary format written by write_binary() is little-endian
+    and can be memory-mapped as it is:
+
+    offset          | type                | content
+    --------------- | ------------------- | -------
+    0               | char[8]             | `"PBTDEMOG"`
+    8               | uint32              | format version (1)
+    12              | uint32              | number of times T
+    16              | uint32              | number of locations L
+    20              | uint32              | number of ages A
+    24              | int32[T][2]         | (year, season) of each census
+    24 + 8T         | uint32[T][L][A]     | counts
+*/
+class Demography {
+  public:
+    //! Alias
+    using count_type = uint32_t;
+    //! constructor
+    Demography(size_t num_locations=0u, size_t num_ages=0u) noexcept
+    : num_locations_(num_locations), num_ages_(num_ages) {}
+
+    //! add a census filled with zero and return its [location][age] counts
+    count_type* append(int_fast32_t year, int_fast32_t season);
+
+    //! number of censuses
+    size_t num_times() const noexcept {return times_.size() / 2u;}
+    //! number of locations
+    size_t num_locations() const noexcept {return num_locations_;}
+    //! number of age classes
+    size_t num_ages() const noexcept {return num_ages_;}
+    //! year of t-th census
+    int_fast32_t year(size_t t) const {return times_[2u * t];}
+    //! season of t-th census
+    int_fast32_t season(size_t t) const {return times_[2u * t + 1u];}
+    //! counts for each age in t-th census at a location
+    const count_type* counts(size_t t, size_t location) const {
+        return counts_.data() + (t * num_locations_ + location) * num_ages_;
+    }
+
+    //! write column names of write()
+    static std::ostream& write_header(std::ostream&);
+    //! write non-zero counts in TSV: year, season, location, age, count
+    std::ostream& write(std::ostream&, bool header=true) const;
+    //! write in the binary format
+    std::ostream& write_binary(std::ostream&) const;
+    //! read the binary format written by write_binary()
+    static Demography read_binary(std::istream&);
+
+  private:
+    //! (year, season) pairs
+    std::vector<int32_t> times_;
+    //! [time][location][age]
+    std::vector<count_type> counts_;
+    //! number of locations
+    size_t num_locations_;
+    //! number of age classes
+    size_t num_ages_;
+};
+
+} // namespace pbf
+
+#endif /* PBT_DEMOGRAPHY_HPP_ */
@@ -2,6 +2,7 @@
     @brief Implementation of Individual class
 */
 #include "individual.hpp"
+#include "alias_table.hpp"
 #include "config.hpp"
 
 #include <wtl/random.hpp>
@@ -9,20 +10,16 @@
 #include <wtl/iostr.hpp>
 #include <clippson/json.hpp>
 
+#include <cmath>
 #include <type_traits>
+#include <stdexcept>
 
 namespace pbf {
 
-Individual::param_type Individual::PARAM_;
-IndividualJson Individual::JSON_;
-
 static_assert(!std::is_default_constructible<Individual>{}, "");
 static_assert(std::is_nothrow_copy_constructible<Individual>{}, "");
 static_assert(std::is_nothrow_move_constructible<Individual>{}, "");
-
-bool Individual::is_dead(const int_fast32_t year, URBG& engine) const {
-    return (wtl::generate_canonical(engine) < JSON_.DEATH_RATE[year - birth_year_]);
-}
+static_assert(std::is_trivially_copyable<Individual>{}, "");
 
 //! Translate parameter `mean` to `prob`
 template <class T> inline wtl::negative_binomial_distribution<T>
@@ -31,52 +28,16 @@ nbinom_distribution(double k, double mu) {
     return wtl::negative_binomial_distribution<T>(k, prob);
 }
 
-uint_fast32_t Individual::recruitment(const int_fast32_t year, const double density_effect, URBG& engine) const noexcept {
-    if (density_effect < 0.0) return 0u;
-    const double mean = density_effect * param().RECRUITMENT_COEF * weight(year);
-    const double k = param().NEGATIVE_BINOM_K;
-    if (k > 0.0) {
-        return nbinom_distribution<uint_fast32_t>(k, mean)(engine);
-    } else {
-        return std::poisson_distribution<uint_fast32_t>(mean)(engine);
-    }
-}
-
-uint_fast32_t Individual::migrate(const uint_fast32_t loc, const int_fast32_t year, URBG& engine) {
-    return JSON_.MIGRATION_DISTRIBUTIONS[year - birth_year_][loc](engine);
-}
-
-void Individual::trace_back(std::ostream& ost, std::unordered_map<const Individual*, uint_fast32_t>* ids,
-                            uint_fast32_t loc, int_fast32_t year) const {
-    if (!ids->emplace(this, static_cast<uint_fast32_t>(ids->size())).second && (year == 0)) return;
-    if (father_) father_->trace_back(ost, ids, loc, 0);
-    if (mother_) mother_->trace_back(ost, ids, loc, 0);
-    write(ost, *ids);
-    if (year > 0) {
-        ost << "\t" << loc << "\t" << year << "\n";
-    } else {
-        ost << "\t\t\n";
-    }
-}
-
 std::vector<std::string> Individual::names() {
     return {"id", "father_id", "mother_id", "birth_year"};
 }
 
 std::ostream& Individual::write(std::ostream& ost) const {
-    return ost << this << "\t"
-               << father_ << "\t"
+    return ost << father_ << "\t"
                << mother_ << "\t"
                << birth_year_;
 }
 
-std::ostream& Individual::write(std::ostream& ost, const std::unordered_map<const Individual*, uint_fast32_t>& ids) const {
-    return ost << ids.at(this) << "\t"
-               << ids.at(father_.get()) << "\t"
-               << ids.at(mother_.get()) << "\t"
-               << birth_year_;
-}
-
 //! Shortcut of Individual::write
 std::ostream& operator<<(std::ostream& ost, const Individual& x) {
     return x.write(ost);
@@ -99,35 +60,20 @@ void elongate(std::vector<T>* v, size_t n) noexcept {
     }
 }
 
-inline std::function<uint_fast32_t(URBG&)> make_dist(const std::vector<double>& v) {
-    uint_fast32_t idx = 0u;
-    unsigned num_positive = 0u;
-    for (uint_fast32_t i=0u; i<v.size(); ++i) {
-        if (v[i] > 0.0) {
-            ++num_positive;
-            idx = i;
-        }
-    }
-    if (num_positive == 1u) {
-        return [idx](URBG&){return idx;};
-    } else {
-        return std::discrete_distribution<uint_fast32_t>(v.begin(), v.end());
-    }
-}
-
 void IndividualJson::set_dependent_static() {
     constexpr int_fast32_t max_age = 80;
-    MIGRATION_DISTRIBUTIONS.clear();
-    MIGRATION_DISTRIBUTIONS.reserve(max_age);
-    for (const auto& matrix: MIGRATION_MATRICES) {
-        decltype(MIGRATION_DISTRIBUTIONS)::value_type dists;
-        dists.reserve(matrix.size());
+    const size_t num_locations = MIGRATION_MATRICES.at(0u).size();
+    MIGRATION_DISTRIBUTIONS = AliasTables(num_locations);
+    for (int_fast32_t age=0; age<max_age; ++age) {
+        const auto i = std::min(static_cast<size_t>(age), MIGRATION_MATRICES.size() - 1u);
+        const auto& matrix = MIGRATION_MATRICES[i];
+        if (matrix.size() != num_locations) {
+            throw std::runtime_error("migration_matrices: inconsistent number of locations");
+        }
         for (const auto& row: matrix) {
-            dists.emplace_back(make_dist(row));
+            MIGRATION_DISTRIBUTIONS.push_back(row);
         }
-        MIGRATION_DISTRIBUTIONS.emplace_back(std::move(dists));
     }
-    elongate(&MIGRATION_DISTRIBUTIONS, max_age);
     DEATH_RATE.reserve(max_age);
     DEATH_RATE.resize(NATURAL_MORTALITY.size() / 4u);
     for (size_t year=0; year<DEATH_RATE.size(); ++year) {
@@ -140,6 +86,11 @@ void IndividualJson::set_dependent_static() {
     }
     elongate(&DEATH_RATE, max_age);
     DEATH_RATE.back() = 1.0;
+    DEATH_THRESHOLD.resize(DEATH_RATE.size());
+    for (size_t age=0; age<DEATH_RATE.size(); ++age) {
+        // u < rate iff (u * 2^53) < ceil(rate * 2^53) for u in [0, 1) of 53 bits
+        DEATH_THRESHOLD[age] = static_cast<uint64_t>(std::ceil(std::ldexp(DEATH_RATE[age], 53)));
+    }
     WEIGHT_FOR_YEAR_AGE.reserve(max_age);
     WEIGHT_FOR_YEAR_AGE.resize(WEIGHT_FOR_AGE.size() / 4u);
     for (size_t year=0; year<WEIGHT_FOR_YEAR_AGE.size(); ++year) {
@@ -148,16 +99,27 @@ void IndividualJson::set_dependent_static() {
     elongate(&WEIGHT_FOR_YEAR_AGE, max_age);
 }
 
+//! Overwrite `*x` if `obj` has `key`
+template <class T> inline
+void get_if_exists(const nlohmann::json& obj, const char* key, T* x) {
+    const auto it = obj.find(key);
+    if (it != obj.end()) *x = it->get<T>();
+}
+
 void IndividualJson::read(std::istream& ist) {
     nlohmann::json obj;
     ist >> obj;
-    NATURAL_MORTALITY = obj.at("natural_mortality").get<decltype(NATURAL_MORTALITY)>();
-    FISHING_MORTALITY = obj.at("fishing_mortality").get<decltype(FISHING_MORTALITY)>();
-    WEIGHT_FOR_AGE = obj.at("weight_for_age").get<decltype(WEIGHT_FOR_AGE)>();
-    MIGRATION_MATRICES = obj.at("migration_matrices").get<decltype(MIGRATION_MATRICES)>();
+    get_if_exists(obj, "natural_mortality", &NATURAL_MORTALITY);
+    get_if_exists(obj, "fishing_mortality", &FISHING_MORTALITY);
+    get_if_exists(obj, "weight_for_age", &WEIGHT_FOR_AGE);
+    get_if_exists(obj, "migration_matrices", &MIGRATION_MATRICES);
     set_dependent_static();
 }
 
+std::vector<std::string> IndividualJson::names() {
+    return {"natural_mortality", "fishing_mortality", "weight_for_age", "migration_matrices"};
+}
+
 void IndividualJson::write(std::ostream& ost) const {
     nlohmann::json obj;
     obj["natural_mortality"] = NATURAL_MORTALITY;
@@ -6,12 +6,12 @@
 #define PBT_INDIVIDUAL_HPP_
 
 #include "random_fwd.hpp"
+#include "alias_table.hpp"
 
 #include <cstdint>
 #include <iosfwd>
-#include <memory>
+#include <string>
 #include <vector>
-#include <unordered_map>
 #include <functional>
 #include <limits>
 
@@ -25,11 +25,11 @@ namespace pbf {
 struct IndividualParams {
     //! @ingroup params
     //@{
-    //! \f$r\f$:  used in Individual::recruitment()
+    //! \f$r\f$:  used in Context::recruitment_at()
     double RECRUITMENT_COEF = 2.0;
-    //! \f$K\f$: carrying capacity used in Individual::recruitment()
+    //! \f$K\f$: carrying capacity used in Population::reproduce()
     double CARRYING_CAPACITY = 1e+3;
-    //! \f$k \in (0, \infty)\f$ for overdispersion in recruitment().
+    //! \f$k \in (0, \infty)\f$ for overdispersion in Context::recruitment_at().
     //! Equivalent to Poisson when \f$k \to \infty\f$ (or \f$k<0\f$ for convience).
     double NEGATIVE_BINOM_K = -1.0;
     //@}
@@ -44,6 +44,7 @@ struct IndividualJson {
     void set_dependent_static();
     void read(std::istream&);
     void write(std::ostream&) const;
+    static std::vector<std::string> names();
     //! @endcond
 
     //! @ingroup params
@@ -60,104 +61,62 @@ struct IndividualJson {
 
     //! finite death rate per year
     std::vector<double> DEATH_RATE;
+    //! DEATH_RATE scaled to 53-bit integers for comparison with `engine() >> 11`
+    std::vector<uint64_t> DEATH_THRESHOLD;
     //! precalculated values (age)
     std::vector<double> WEIGHT_FOR_YEAR_AGE;
-    //! discrete distributions for migration
-    std::vector<std::vector<std::function<uint_fast32_t(URBG&)>>> MIGRATION_DISTRIBUTIONS;
+    //! samplers of destination for each (age, location) in rows `age * L + location`
+    AliasTables MIGRATION_DISTRIBUTIONS;
 };
 
 /*! @brief Individual class
+
+    Parents are referred to by 32-bit handles into Pedigree,
+    which owns every Individual; 0 means "unknown".
 */
 class Individual {
   public:
-    //! Alias
-    using param_type = IndividualParams;
+    //! Index in Pedigree
+    using handle_type = uint32_t;
     Individual() = delete;
     //! for initial population
     explicit Individual(bool is_male): is_male_(is_male) {}
     //! for sexual reproduction
-    Individual(const std::shared_ptr<Individual>& father,
-               const std::shared_ptr<Individual>& mother, int_fast32_t year, bool is_male)
+    Individual(handle_type father, handle_type mother, int_fast32_t year, bool is_male)
     : father_(father), mother_(mother),
-      birth_year_(year), is_male_(is_male) {}
-
-    //! evaluate survival
-    bool is_dead(const int_fast32_t year, URBG&) const;
+      birth_year_(static_cast<int32_t>(year)), is_male_(is_male) {}
 
-    //! number of juveniles
-    uint_fast32_t recruitment(int_fast32_t year, double density_effect, URBG&) const noexcept;
-
-    //! return new location
-    uint_fast32_t migrate(uint_fast32_t loc, int_fast32_t year, URBG&);
-
-    //! collect ancestoral IDs
-    void trace_back(std::ostream& ost, std::unordered_map<const Individual*, uint_fast32_t>* ids,
-                    uint_fast32_t loc, int_fast32_t year) const;
     //! write all the data members in TSV
     std::ostream& write(std::ostream&) const;
-    //! write all the data members in TSV with translated IDs
-    std::ostream& write(std::ostream&, const std::unordered_map<const Individual*, uint_fast32_t>&) const;
     friend std::ostream& operator<<(std::ostream&, const Individual&);
     //! column names for write()
     static std::vector<std::string> names();
     //! Get default parameters in json
     static std::string default_json();
-    //! Read class variables from stream in json
-    static void read_json(std::istream& ist) {JSON_.read(ist);}
-    //! Write class variables to stream in json
-    static void write_json(std::ostream& ost) {JSON_.write(ost);}
     //! Export negative_binomial_distribution to Rcpp for testing
     static std::vector<int> rnbinom(int n, double k, double mu);
-    //! Set #PARAM_
-    static void param(const param_type& p) {PARAM_ = p;}
-    //! Get #PARAM_
-    static const param_type& param() {return PARAM_;}
 
     //! @name Getter functions
     //@{
-    //! IndividualJson.NATURAL_MORTALITY
-    static const std::vector<double>&
-    natural_mortality() {return JSON_.NATURAL_MORTALITY;}
-    //! IndividualJson.FISHING_MORTALITY
-    static const std::vector<double>&
-    fishing_mortality() {return JSON_.FISHING_MORTALITY;}
-    //! IndividualJson.DEATH_RATE
-    static const std::vector<double>&
-    death_rate() {return JSON_.DEATH_RATE;}
-    //! IndividualJson.WEIGHT_FOR_AGE
-    static const std::vector<double>&
-    weight_for_age() {return JSON_.WEIGHT_FOR_AGE;}
-    //! IndividualJson.MIGRATION_MATRICES
-    static const std::vector<std::vector<std::vector<double>>>&
-    migration_matrices() {return JSON_.MIGRATION_MATRICES;}
-    //! IndividualJson.WEIGHT_FOR_YEAR_AGE
-    double weight(int_fast32_t year) const noexcept {
-        return JSON_.WEIGHT_FOR_YEAR_AGE[year - birth_year_];
-    }
     //! !#father_
     bool is_first_gen() const noexcept {return !father_;}
     //! @cond
-    const Individual* father_get() const noexcept {return father_.get();}
-    const Individual* mother_get() const noexcept {return mother_.get();}
+    handle_type father() const noexcept {return father_;}
+    handle_type mother() const noexcept {return mother_;}
     int_fast32_t birth_year() const noexcept {return birth_year_;}
     bool is_male() const noexcept {return is_male_;}
     //! @endcond
     //@}
 
   private:
-    //! Parameters shared among instances (command-line)
-    static param_type PARAM_;
-    //! Parameters shared among instances (JSON file)
-    static IndividualJson JSON_;
-
     //! father
-    const std::shared_ptr<Individual> father_ = nullptr;
+    handle_type father_ = 0u;
     //! mother
-    const std::shared_ptr<Individual> mother_ = nullptr;
+    handle_type mother_ = 0u;
     //! year of birth
-    int_fast32_t birth_year_ = -4;
+    int32_t birth_year_ = -4;
     //! sex
-    const bool is_male_;
+    bool is_male_;
 };
 
 } // namespace pbf
@@ -0,0 +1,101 @@
+/*! @file kernels.cpp
+    @brief Implementation of batched kernels
+*/
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+namespace pbf {
+
+namespace {
+
+//! Number of random numbers generated at once
+constexpr size_t BATCH_SIZE = 1024u;
+
+// Masked forms with zeroed sources are used below where needed;
+// the unmasked ones have undefined sources that GCC 12 reports as
+// -Wmaybe-uninitialized (https://gcc.gnu.org/PR105593).
+
+#if defined(__AVX512F__)
+//! all 8 lanes of 64-bit elements
+constexpr __mmask8 ALL_LANES = 0xFFu;
+#endif
+
+//! compare a batch of `n <= BATCH_SIZE` individuals with 64-bit random numbers
+void compare_thresholds(const int32_t* birth_year, const size_t n, const int32_t year,
+                        const uint64_t* thresholds, const uint64_t* bits, uint8_t* is_dead) noexcept {
+    size_t i = 0u;
+#if defined(__AVX512F__)
+    const __m256i year_v = _mm256_set1_epi32(year);
+    for (; i + 8u <= n; i += 8u) {
+        const __m256i by = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(birth_year + i));
+        const __m256i age = _mm256_sub_epi32(year_v, by);
+        const __m512i threshold = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), ALL_LANES, age, thresholds, 8);
+        const __m512i u = _mm512_maskz_srli_epi64(ALL_LANES, _mm512_loadu_si512(bits + i), 11);
+        const __mmask8 dead = _mm512_cmplt_epu64_mask(u, threshold);
+        const __m128i bytes = _mm512_maskz_cvtepi64_epi8(ALL_LANES, _mm512_maskz_set1_epi64(dead, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(is_dead + i), bytes);
+    }
+#elif defined(__AVX2__)
+    const __m128i year_v = _mm_set1_epi32(year);
+    const auto table = reinterpret_cast<const long long*>(thresholds);
+    for (; i + 4u <= n; i += 4u) {
+        const __m128i by = _mm_loadu_si128(reinterpret_cast<const __m128i*>(birth_year + i));
+        const __m128i age = _mm_sub_epi32(year_v, by);
+        const __m256i threshold = _mm256_i32gather_epi64(table, age, 8);
+        const __m256i u = _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits + i)), 11);
+        // both are below 2^63, so that signed comparison is safe
+        const int dead = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(threshold, u)));
+        for (unsigned j=0u; j<4u; ++j) {
+            is_dead[i + j] = static_cast<uint8_t>((dead >> j) & 1);
+        }
+    }
+#endif
+    for (; i<n; ++i) {
+        is_dead[i] = (bits[i] >> 11) < thresholds[year - birth_year[i]];
+    }
+}
+
+} // namespace
+
+void mark_deaths(const int32_t* birth_year, const size_t n, const int32_t year,
+                 const uint64_t* thresholds, URBG& engine, uint8_t* is_dead) {
+    URBG::result_type bits[BATCH_SIZE];
+    for (size_t begin=0u; begin<n; begin+=BATCH_SIZE) {
+        const size_t size = std::min(BATCH_SIZE, n - begin);
+        engine.generate(bits, size);
+        compare_thresholds(birth_year + begin, size, year, thresholds, bits, is_dead + begin);
+    }
+}
+
+void fill_recruitment_means(const int32_t* birth_year, const size_t n, const int32_t year,
+                            const double factor, const double* weights, double* means) noexcept {
+    size_t i = 0u;
+#if defined(__AVX512F__)
+    const __m256i year_v = _mm256_set1_epi32(year);
+    const __m512d factor_v = _mm512_set1_pd(factor);
+    for (; i + 8u <= n; i += 8u) {
+        const __m256i by = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(birth_year + i));
+        const __m512d w = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), ALL_LANES, _mm256_sub_epi32(year_v, by), weights, 8);
+        _mm512_storeu_pd(means + i, _mm512_mul_pd(factor_v, w));
+    }
+#elif defined(__AVX2__)
+    const __m128i year_v = _mm_set1_epi32(year);
+    const __m256d factor_v = _mm256_set1_pd(factor);
+    for (; i + 4u <= n; i += 4u) {
+        const __m128i by = _mm_loadu_si128(reinterpret_cast<const __m128i*>(birth_year + i));
+        const __m256d w = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), weights, _mm_sub_epi32(year_v, by),
+                                                   _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+        _mm256_storeu_pd(means + i, _mm256_mul_pd(factor_v, w));
+    }
+#endif
+    for (; i<n; ++i) {
+        means[i] = factor * weights[year - birth_year[i]];
+    }
+}
+
+} // namespace pbf
@@ -0,0 +1,37 @@
+/*! @file kernels.hpp
+    @brief Batched per-individual kernels over Subpopulation columns
+*/
+#pragma once
+#ifndef PBT_KERNELS_HPP_
+#define PBT_KERNELS_HPP_
+
+#include "random_fwd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Evaluate survival of `n` individuals at once
+
+    `is_dead[i]` is set to 1 if `(engine() >> 11) < thresholds[year - birth_year[i]]`,
+    consuming `n` outputs of `engine` in the same order as Context::is_dead_at().
+    Random numbers are generated in bulk with `URBG::generate()`,
+    and thresholds are gathered and compared with AVX-512 or AVX2 if available.
+*/
+void mark_deaths(const int32_t* birth_year, size_t n, int32_t year,
+                 const uint64_t* thresholds, URBG& engine, uint8_t* is_dead);
+
+/*! @brief Mean recruitment of `n` individuals at once
+
+    `means[i] = factor * weights[year - birth_year[i]]`,
+    which is bit-identical to the scalar product in Context::recruitment_at().
+*/
+void fill_recruitment_means(const int32_t* birth_year, size_t n, int32_t year,
+                            double factor, const double* weights, double* means) noexcept;
+
+} // namespace pbf
+
+#endif /* PBT_KERNELS_HPP_ */
@@ -3,6 +3,8 @@
 */
 #include "program.hpp"
 #include "population.hpp"
+#include "demography.hpp"
+#include "profile.hpp"
 
 #include <wtl/filesystem.hpp>
 #ifdef ZLIB_FOUND
@@ -11,32 +13,94 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <memory>
 #include <stdexcept>
 
-//! Output results to files
-void write(const pbf::Program& program) {
-  #ifdef ZLIB_FOUND
-    using ofstream = wtl::zlib::ofstream;
-    const std::string ext = ".tsv.gz";
-  #else
-    using ofstream = std::ofstream;
-    const std::string ext = ".tsv";
-  #endif
-    const auto& population = program.population();
+#ifdef ZLIB_FOUND
+  using ofstream = wtl::zlib::ofstream;
+  const std::string ext = ".tsv.gz";
+#else
+  using ofstream = std::ofstream;
+  const std::string ext = ".tsv";
+#endif
+
+//! Prefix of output files for the i-th replicate
+std::string replicate_prefix(const pbf::Program& program, const size_t i) {
+    if (program.num_replicates() <= 1u) return "";
+    std::ostringstream prefix;
+    prefix << "rep" << std::setw(4) << std::setfill('0') << i << "_";
+    return prefix.str();
+}
+
+//! Write censuses to a stream as soon as they are taken
+pbf::Program::demography_sink_type stream_demography(std::shared_ptr<std::ostream> ost) {
+    pbf::Demography::write_header(*ost);
+    return [ost](const pbf::Demography& census) {census.write(*ost, false);};
+}
+
+//! Output results of a replicate to files in the current directory
+/*! Demography has been streamed to a file unless `binary`.
+*/
+void write(const pbf::Population& population, const std::string& prefix, const bool binary) {
+    {
+        ofstream ost{prefix + "sample_family" + ext};
+        population.write_sample_family(ost);
+    }
+    if (!binary) return;
+    {
+        ofstream ost{prefix + "demography" + ext};
+        population.write_demography(ost);
+    }
+    {
+        std::ofstream ost{prefix + "sample_family.bin", std::ios::binary};
+        population.write_sample_family_binary(ost);
+    }
+    {
+        std::ofstream ost{prefix + "demography.bin", std::ios::binary};
+        population.write_demography_binary(ost);
+    }
+}
+
+//! Run and output results to files
+void run(pbf::Program& program) {
     const auto outdir = program.outdir();
-    if (!outdir.empty()) {
-        wtl::ChDir cd(outdir, true);
-        std::ofstream{"config.json"} << program.config();
-        {
-            ofstream ost{"sample_family" + ext};
-            population.write_sample_family(ost);
-        }
-        {
-            ofstream ost{"demography" + ext};
-            population.write_demography(ost);
-        }
-    } else {
-        population.write_demography(std::cout);
+    if (program.is_sweep() && outdir.empty()) {
+        program.sweep(std::cout);
+        return;
+    }
+    if (outdir.empty()) {
+        // only the first replicate is written
+        program.run(nullptr, [](size_t i) -> pbf::Program::demography_sink_type {
+            if (i > 0u) return [](const pbf::Demography&) {};
+            return stream_demography(std::shared_ptr<std::ostream>(&std::cout, [](std::ostream*) {}));
+        });
+        return;
+    }
+    wtl::ChDir cd(outdir, true);
+    std::ofstream{"config.json"} << program.config();
+    if (program.is_sweep()) {
+        std::ofstream ost{"summary.tsv"};
+        ost.precision(std::cout.precision());
+        program.sweep(ost);
+        return;
+    }
+    const bool binary = program.writes_binary();
+    pbf::Program::sink_factory_type make_sink = nullptr;
+    if (!binary) {
+        // binary format needs all the censuses at the end
+        make_sink = [&program](size_t i) {
+            return stream_demography(std::make_shared<ofstream>(replicate_prefix(program, i) + "demography" + ext));
+        };
+    }
+    program.run([&program, binary](const pbf::Population& population, size_t i) {
+        pbf::Profile::Scope scope(i == 0u ? program.profile() : nullptr, pbf::Profile::Phase::output);
+        write(population, replicate_prefix(program, i), binary);
+    }, make_sink);
+    if (program.profile()) {
+        std::ofstream ost{"profile.json"};
+        program.profile()->write_json(ost);
     }
 }
 
@@ -45,8 +109,7 @@ int main(int argc, char* argv[]) {
     std::vector<std::string> arguments(argv + 1, argv + argc);
     try {
         pbf::Program program(arguments);
-        program.run();
-        write(program);
+        run(program);
     } catch (const std::runtime_error& e) {
         std::cerr << e.what() << std::endl;
     }
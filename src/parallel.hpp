@@ -0,0 +1,58 @@
+/*! @file parallel.hpp
+    @brief Minimal helper for data-parallel loops
+*/
+#pragma once
+#ifndef PBT_PARALLEL_HPP_
+#define PBT_PARALLEL_HPP_
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pbf {
+
+//! Call `fn(i)` for each `i` in [0, n) on up to `num_threads` threads.
+/*! Tasks are handed out dynamically, so `fn` must not depend on
+    which thread or in which order it is called.
+    The calling thread takes part in the work.
+    The first exception thrown by `fn` stops handing out tasks
+    and is rethrown after all the threads have finished.
+*/
+template <class Function> inline
+void parallel_for(unsigned num_threads, size_t n, Function&& fn) {
+    const size_t num_workers = std::min(static_cast<size_t>(num_threads), n);
+    if (num_workers <= 1u) {
+        for (size_t i=0; i<n; ++i) fn(i);
+        return;
+    }
+    std::atomic<size_t> next{0u};
+    std::exception_ptr error = nullptr;
+    std::mutex mtx;
+    auto worker = [&fn, &next, &error, &mtx, n]() {
+        for (size_t i=next++; i<n; i=next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) error = std::current_exception();
+                next = n;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_workers - 1u);
+    for (size_t t=1u; t<num_workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread: threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace pbf
+
+#endif /* PBT_PARALLEL_HPP_ */
@@ -0,0 +1,258 @@
+/*! @file pedigree.cpp
+    @brief Implementation of Pedigree class
+*/
+#include "pedigree.hpp"
+#include "binary.hpp"
+
+#include <ostream>
+#include <stdexcept>
+#include <limits>
+
+namespace pbf {
+
+Pedigree::Pedigree()
+: nodes_(1u, Individual(false)), refcounts_(1u, 0u), ids_(1u, 0u) {}
+
+Pedigree::handle_type Pedigree::allocate(const Individual& x, const id_type id) {
+    if (!vacant_.empty()) {
+        const handle_type handle = vacant_.back();
+        vacant_.pop_back();
+        const size_t i = handle - num_frozen_;
+        nodes_[i] = x;
+        refcounts_[handle] = 1u;
+        ids_[i] = id;
+        return handle;
+    }
+    const size_t handle = num_frozen_ + nodes_.size();
+    if (handle > std::numeric_limits<handle_type>::max()) {
+        throw std::overflow_error("Pedigree: too many individuals for 32-bit handles");
+    }
+    nodes_.push_back(x);
+    refcounts_.push_back(1u);
+    ids_.push_back(id);
+    return static_cast<handle_type>(handle);
+}
+
+Pedigree::handle_type Pedigree::emplace(bool is_male) {
+    return allocate(Individual(is_male), next_id_++);
+}
+
+Pedigree::handle_type Pedigree::emplace(handle_type father, handle_type mother, int_fast32_t year, bool is_male) {
+    return emplace(father, mother, year, is_male, next_id_++);
+}
+
+Pedigree::handle_type Pedigree::emplace(handle_type father, handle_type mother, int_fast32_t year, bool is_male,
+                                        const id_type id) {
+    if (father) ++refcounts_[father];
+    if (mother) ++refcounts_[mother];
+    return allocate(Individual(father, mother, year, is_male), id);
+}
+
+void Pedigree::release(handle_type handle) {
+    // no allocation unless the record becomes vacant
+    if (handle == 0u) return;
+    if (refcounts_[handle] > 1u) {
+        --refcounts_[handle];
+        return;
+    }
+    std::vector<handle_type> stack{handle};
+    while (!stack.empty()) {
+        const handle_type h = stack.back();
+        stack.pop_back();
+        if (h == 0u || --refcounts_[h] > 0u) continue;
+        if (h < num_frozen_) {
+            ++num_frozen_vacant_;
+        } else {
+            vacant_.push_back(h);
+        }
+        const Individual& x = (*this)[h];
+        stack.push_back(x.father());
+        stack.push_back(x.mother());
+    }
+}
+
+void Pedigree::freeze() {
+    if (nodes_.empty()) return;
+    auto frozen = std::make_shared<Frozen>();
+    frozen->begin = static_cast<handle_type>(num_frozen_);
+    frozen->nodes = std::move(nodes_);
+    frozen->ids = std::move(ids_);
+    frozen->nodes.shrink_to_fit();
+    frozen->ids.shrink_to_fit();
+    num_frozen_ += frozen->nodes.size();
+    frozen_.push_back(std::move(frozen));
+    nodes_.clear();
+    ids_.clear();
+    // a branch copies the counts with exactly this capacity
+    refcounts_.shrink_to_fit();
+    // vacant records of this branch are vacant in the branch, too
+    num_frozen_vacant_ += vacant_.size();
+    std::vector<handle_type>().swap(vacant_);
+}
+
+std::unique_ptr<Pedigree> Pedigree::fork() {
+    freeze();
+    return std::make_unique<Pedigree>(*this);
+}
+
+std::vector<Pedigree::handle_type> Pedigree::compact() {
+    constexpr auto VACANT = std::numeric_limits<handle_type>::max();
+    // frozen records are copied into this branch if any of them is vacant
+    const bool is_thawing = (num_frozen_vacant_ > 0u);
+    const size_t first = is_thawing ? 0u : num_frozen_;
+    const size_t n = num_frozen_ + nodes_.size();
+    std::vector<handle_type> moved(n, 0u);
+    for (size_t h=0u; h<first; ++h) moved[h] = static_cast<handle_type>(h);
+    for (const auto h: vacant_) moved[h] = VACANT;
+    std::vector<Individual> thawed;
+    std::vector<id_type> thawed_ids;
+    if (is_thawing) {
+        for (size_t h=1u; h<num_frozen_; ++h) {
+            if (refcounts_[h] == 0u) moved[h] = VACANT;
+        }
+        thawed.reserve(n - num_vacant());
+        thawed_ids.reserve(n - num_vacant());
+    }
+    size_t j = first;
+    for (size_t h=first; h<n; ++h) {
+        if (moved[h] == VACANT) {
+            moved[h] = 0u;
+            continue;
+        }
+        moved[h] = static_cast<handle_type>(j);
+        refcounts_[j] = refcounts_[h];
+        if (is_thawing) {
+            thawed.push_back((*this)[static_cast<handle_type>(h)]);
+            thawed_ids.push_back(id(static_cast<handle_type>(h)));
+        } else {
+            nodes_[j - first] = nodes_[h - first];
+            ids_[j - first] = ids_[h - first];
+        }
+        ++j;
+    }
+    if (is_thawing) {
+        nodes_.swap(thawed);
+        ids_.swap(thawed_ids);
+        frozen_.clear();
+        num_frozen_ = 0u;
+        num_frozen_vacant_ = 0u;
+    }
+    const size_t num_own = j - num_frozen_;
+    for (size_t i=0u; i<num_own; ++i) {
+        const Individual& x = nodes_[i];
+        nodes_[i] = Individual(moved[x.father()], moved[x.mother()], x.birth_year(), x.is_male());
+    }
+    nodes_.erase(nodes_.begin() + static_cast<ptrdiff_t>(num_own), nodes_.end());
+    refcounts_.resize(j);
+    ids_.resize(num_own);
+    nodes_.shrink_to_fit();
+    refcounts_.shrink_to_fit();
+    ids_.shrink_to_fit();
+    std::vector<handle_type>().swap(vacant_);
+    return moved;
+}
+
+size_t Pedigree::bytes() const noexcept {
+    size_t total = nodes_.capacity() * sizeof(Individual)
+                 + refcounts_.capacity() * sizeof(uint32_t)
+                 + ids_.capacity() * sizeof(id_type)
+                 + vacant_.capacity() * sizeof(handle_type);
+    for (const auto& segment: frozen_) {
+        total += segment->nodes.capacity() * sizeof(Individual)
+               + segment->ids.capacity() * sizeof(id_type);
+    }
+    return total;
+}
+
+std::vector<Pedigree::handle_type>
+Pedigree::collect_ancestors(const std::vector<handle_type>& roots) const {
+    std::vector<bool> is_visited(num_frozen_ + nodes_.size(), false);
+    is_visited[0u] = true;
+    for (const auto h: roots) is_visited[h] = true;
+    std::vector<handle_type> ancestors;
+    std::vector<handle_type> stack;
+    for (const auto h: roots) {
+        stack.push_back((*this)[h].mother());
+        stack.push_back((*this)[h].father());
+        while (!stack.empty()) {
+            const handle_type x = stack.back();
+            stack.pop_back();
+            if (is_visited[x]) continue;
+            is_visited[x] = true;
+            ancestors.push_back(x);
+            stack.push_back((*this)[x].mother());
+            stack.push_back((*this)[x].father());
+        }
+    }
+    return ancestors;
+}
+
+std::ostream& Pedigree::write(std::ostream& ost, const handle_type handle) const {
+    const Individual& x = (*this)[handle];
+    return ost << id(handle) << "\t"
+               << id(x.father()) << "\t"
+               << id(x.mother()) << "\t"
+               << x.birth_year();
+}
+
+std::ostream& Pedigree::write_binary(std::ostream& ost) const {
+    const size_t n = num_frozen_ + nodes_.size();
+    std::vector<handle_type> father(n), mother(n);
+    std::vector<int32_t> birth_year(n);
+    std::vector<uint8_t> is_male(n);
+    std::vector<id_type> ids(n);
+    for (size_t i=0; i<n; ++i) {
+        const auto handle = static_cast<handle_type>(i);
+        const Individual& x = (*this)[handle];
+        father[i] = x.father();
+        mother[i] = x.mother();
+        birth_year[i] = static_cast<int32_t>(x.birth_year());
+        is_male[i] = x.is_male();
+        ids[i] = id(handle);
+    }
+    std::vector<handle_type> vacant(vacant_);
+    for (size_t h=1u; h<num_frozen_; ++h) {
+        if (refcounts_[h] == 0u) vacant.push_back(static_cast<handle_type>(h));
+    }
+    binary::write_vector(ost, father);
+    binary::write_vector(ost, mother);
+    binary::write_vector(ost, birth_year);
+    binary::write_vector(ost, is_male);
+    binary::write_vector(ost, ids);
+    binary::write_vector(ost, refcounts_);
+    binary::write_vector(ost, vacant);
+    binary::write(ost, next_id_);
+    return ost;
+}
+
+void Pedigree::read_binary(std::istream& ist) {
+    std::vector<handle_type> father, mother;
+    std::vector<int32_t> birth_year;
+    std::vector<uint8_t> is_male;
+    binary::read_vector(ist, &father);
+    binary::read_vector(ist, &mother);
+    binary::read_vector(ist, &birth_year);
+    binary::read_vector(ist, &is_male);
+    binary::read_vector(ist, &ids_);
+    binary::read_vector(ist, &refcounts_);
+    binary::read_vector(ist, &vacant_);
+    next_id_ = binary::read<id_type>(ist);
+    const size_t n = father.size();
+    if (n == 0u || mother.size() != n || birth_year.size() != n ||
+        is_male.size() != n || ids_.size() != n || refcounts_.size() != n) {
+        throw std::runtime_error("Pedigree: broken binary input");
+    }
+    for (const auto h: vacant_) {
+        if (h == 0u || h >= n) throw std::runtime_error("Pedigree: broken binary input");
+    }
+    nodes_.clear();
+    nodes_.reserve(n);
+    for (size_t i=0; i<n; ++i) {
+        nodes_.emplace_back(father[i], mother[i], birth_year[i], is_male[i] != 0u);
+    }
+    frozen_.clear();
+    num_frozen_ = 0u;
+    num_frozen_vacant_ = 0u;
+}
+
+} // namespace pbf
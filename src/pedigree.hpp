@@ -0,0 +1,170 @@
+/*! @file pedigree.hpp
+    @brief Interface of Pedigree class
+*/
+#pragma once
+#ifndef PBT_PEDIGREE_HPP_
+#define PBT_PEDIGREE_HPP_
+
+#include "individual.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include <memory>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Pool of Individual records linked by 32-bit handles
+
+    Each record has a reference count held by its owner in Population
+    (subpopulation, juveniles, or samples) and by each of its children.
+    Counts are plain integers because a Pedigree is never shared between threads.
+    A record is recycled as soon as its count drops to zero,
+    and the whole pool is released at once on destruction.
+    Handles are reused, but each record also gets a serial ID at birth
+    that is never reused and is written in the output instead of the handle.
+
+    fork() moves the records so far into an immutable segment
+    shared by the original and the branch (copy-on-write).
+    Segments are chained rather than merged,
+    so that forking again copies nothing but the reference counts,
+    which each branch keeps for all the records including frozen ones.
+    A frozen record whose count drops to zero cannot be recycled in place,
+    and its ancestors are released as usual.
+    Once some of them are vacant, compact() copies the frozen records in use
+    and drops the segments, which are released
+    when the last Pedigree sharing them drops them or is destroyed.
+*/
+class Pedigree {
+  public:
+    //! Alias
+    using handle_type = Individual::handle_type;
+    //! Alias
+    using id_type = uint64_t;
+    //! constructor; handle 0 is reserved for unknown parents
+    Pedigree();
+
+    //! add a first-generation individual with one reference
+    handle_type emplace(bool is_male);
+    //! add a child with one reference; its parents gain one reference each
+    handle_type emplace(handle_type father, handle_type mother, int_fast32_t year, bool is_male);
+    //! add a child with an ID from take_ids() instead of the next one
+    handle_type emplace(handle_type father, handle_type mother, int_fast32_t year, bool is_male, id_type id);
+    //! skip `n` serial IDs to be given to records created later; return the first
+    id_type take_ids(size_t n) noexcept {
+        const id_type first = next_id_;
+        next_id_ += n;
+        return first;
+    }
+    //! add a reference to a record held outside Pedigree, e.g., by Families
+    void retain(handle_type handle) noexcept {
+        if (handle) ++refcounts_[handle];
+    }
+    //! drop a reference, recycling the record and its unreachable ancestors
+    void release(handle_type handle);
+    //! reserve memory for n records in total
+    void reserve(size_t n) {
+        const size_t own = (n + 1u > num_frozen_) ? n + 1u - num_frozen_ : 0u;
+        nodes_.reserve(own);
+        refcounts_.reserve(num_frozen_ + own);
+        ids_.reserve(own);
+    }
+    //! freeze the records so far and return a branch sharing them
+    /*! Handles and IDs remain valid in both.
+        New records in either are not visible from the other.
+    */
+    std::unique_ptr<Pedigree> fork();
+    //! move the records in use over vacant ones and release spare memory
+    /*! Frozen records are copied and their segments are dropped
+        if any of them is vacant in this branch; otherwise they are not moved.
+        @return New handle for each old handle; 0 if vacant
+    */
+    std::vector<handle_type> compact();
+
+    //! access the record
+    const Individual& operator[](handle_type handle) const noexcept {
+        if (handle >= num_frozen_) return nodes_[handle - num_frozen_];
+        const Frozen& segment = frozen_segment(handle);
+        return segment.nodes[handle - segment.begin];
+    }
+    //! serial ID given at birth; 0 for unknown parents
+    id_type id(handle_type handle) const noexcept {
+        if (handle >= num_frozen_) return ids_[handle - num_frozen_];
+        const Frozen& segment = frozen_segment(handle);
+        return segment.ids[handle - segment.begin];
+    }
+    //! number of records in use including frozen ones
+    size_t size() const noexcept {
+        return num_frozen_ + nodes_.size() - vacant_.size() - num_frozen_vacant_ - 1u;
+    }
+    //! number of frozen records shared with other branches
+    size_t num_frozen() const noexcept {return num_frozen_;}
+    //! number of vacant records including frozen ones not in use in this branch
+    size_t num_vacant() const noexcept {return vacant_.size() + num_frozen_vacant_;}
+    //! number of frozen records not in use in this branch
+    size_t num_frozen_vacant() const noexcept {return num_frozen_vacant_;}
+    //! bytes allocated for the records including frozen ones shared with others
+    size_t bytes() const noexcept;
+
+    //! ancestors of `roots` excluding `roots` themselves, each once
+    /*! Iterative depth-first search marking visited records in a bitmap,
+        so that the cost is linear in the number of records reached.
+    */
+    std::vector<handle_type> collect_ancestors(const std::vector<handle_type>& roots) const;
+    //! write id, father_id, mother_id, and birth_year in TSV without newline
+    std::ostream& write(std::ostream& ost, handle_type handle) const;
+
+    //! write all the records including vacant ones in binary
+    std::ostream& write_binary(std::ostream&) const;
+    //! replace all the records with those written by write_binary()
+    /*! Frozen records are restored as records of this Pedigree alone,
+        and those not in use are recycled.
+    */
+    void read_binary(std::istream&);
+
+  private:
+    //! Immutable records shared among branches
+    struct Frozen {
+        //! handle of the first record
+        handle_type begin;
+        //! records; index is handle - begin
+        std::vector<Individual> nodes;
+        //! serial IDs; index is handle - begin
+        std::vector<id_type> ids;
+    };
+
+    //! take a recycled record or append a new one
+    handle_type allocate(const Individual& x, id_type id);
+    //! move the records of this branch into a new segment of #frozen_
+    void freeze();
+    //! segment containing a handle below #num_frozen_
+    const Frozen& frozen_segment(handle_type handle) const noexcept {
+        // segments are few: one per fork() in the history of this branch
+        auto it = frozen_.end();
+        while ((*--it)->begin > handle) {}
+        return **it;
+    }
+
+    //! segments of handles below #num_frozen_ in ascending order
+    std::vector<std::shared_ptr<const Frozen>> frozen_;
+    //! number of frozen records
+    size_t num_frozen_ = 0u;
+    //! number of frozen records not in use in this branch
+    size_t num_frozen_vacant_ = 0u;
+    //! records; index is handle - #num_frozen_
+    std::vector<Individual> nodes_;
+    //! number of references to each record in this branch; index is handle
+    std::vector<uint32_t> refcounts_;
+    //! serial IDs; index is handle - #num_frozen_
+    std::vector<id_type> ids_;
+    //! recycled handles
+    std::vector<handle_type> vacant_;
+    //! ID for the next record
+    id_type next_id_ = 1u;
+};
+
+} // namespace pbf
+
+#endif /* PBT_PEDIGREE_HPP_ */
@@ -0,0 +1,158 @@
+/*! @file pedigree_file.cpp
+    @brief Implementation of binary pedigree format
+*/
+#include "pedigree_file.hpp"
+#include "binary.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace pbf {
+
+namespace {
+
+//! Tag at the beginning of binary files
+constexpr char MAGIC[9] = "PBTPEDIG";
+//! Version of the binary format
+constexpr uint32_t VERSION = 1u;
+//! Number of columns
+constexpr uint32_t NUM_COLUMNS = 6u;
+//! Size of the header including the offset table
+constexpr size_t HEADER_SIZE = 24u + 8u * NUM_COLUMNS;
+//! Width of each column in bytes
+constexpr size_t WIDTHS[NUM_COLUMNS] = {8u, 8u, 8u, 4u, 4u, 4u};
+
+//! Write elements of `v` in the order of `rows`
+template <class T> inline
+void write_column(std::ostream& ost, const std::vector<T>& v, const std::vector<size_t>& rows) {
+    std::vector<T> sorted;
+    sorted.reserve(rows.size());
+    for (const auto i: rows) sorted.push_back(v[i]);
+    binary::write(ost, sorted.data(), sorted.size());
+}
+
+} // namespace
+
+void PedigreeColumns::push_back(uint64_t id_, uint64_t father_id_, uint64_t mother_id_,
+                                int32_t birth_year_, int32_t location_, int32_t capture_year_) {
+    id.push_back(id_);
+    father_id.push_back(father_id_);
+    mother_id.push_back(mother_id_);
+    birth_year.push_back(birth_year_);
+    location.push_back(location_);
+    capture_year.push_back(capture_year_);
+}
+
+std::ostream& PedigreeColumns::write(std::ostream& ost) const {
+    const size_t n = size();
+    std::vector<size_t> rows(n);
+    std::iota(rows.begin(), rows.end(), size_t{0u});
+    std::sort(rows.begin(), rows.end(), [this](size_t i, size_t j) {return id[i] < id[j];});
+    binary::write_magic(ost, MAGIC);
+    binary::write(ost, VERSION);
+    binary::write(ost, NUM_COLUMNS);
+    binary::write(ost, static_cast<uint64_t>(n));
+    uint64_t offset = HEADER_SIZE;
+    for (const auto width: WIDTHS) {
+        binary::write(ost, offset);
+        offset += width * n;
+        offset += (8u - offset % 8u) % 8u;
+    }
+    auto pad = [&ost](size_t bytes) {
+        for (size_t i=bytes; i % 8u; ++i) ost.put('\0');
+    };
+    write_column(ost, id, rows);
+    write_column(ost, father_id, rows);
+    write_column(ost, mother_id, rows);
+    write_column(ost, birth_year, rows);
+    pad(4u * n);
+    write_column(ost, location, rows);
+    pad(4u * n);
+    write_column(ost, capture_year, rows);
+    pad(4u * n);
+    return ost;
+}
+
+PedigreeFile::PedigreeFile(const std::string& path) {
+    if (!binary::is_little_endian()) {
+        throw std::runtime_error("PedigreeFile: big-endian hosts are not supported");
+    }
+#ifdef _WIN32
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) throw std::runtime_error("cannot open " + path);
+    buffer_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    data_ = buffer_.data();
+    length_ = buffer_.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    length_ = static_cast<size_t>(st.st_size);
+    if (length_ > 0u) {
+        void* p = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("cannot mmap " + path);
+        data_ = static_cast<const char*>(p);
+    } else {
+        ::close(fd);
+    }
+#endif
+    auto fail = [this, &path](const char* what) {
+        unmap();
+        throw std::runtime_error(path + ": " + what);
+    };
+    if (length_ < HEADER_SIZE || std::memcmp(data_, MAGIC, 8u) != 0) fail("not a binary pedigree");
+    uint32_t version, num_columns;
+    uint64_t num_rows, offsets[NUM_COLUMNS];
+    std::memcpy(&version, data_ + 8u, 4u);
+    std::memcpy(&num_columns, data_ + 12u, 4u);
+    std::memcpy(&num_rows, data_ + 16u, 8u);
+    std::memcpy(offsets, data_ + 24u, 8u * NUM_COLUMNS);
+    if (version != VERSION || num_columns != NUM_COLUMNS) fail("unsupported version");
+    size_ = static_cast<size_t>(num_rows);
+    for (uint32_t j=0u; j<NUM_COLUMNS; ++j) {
+        if (offsets[j] % WIDTHS[j] || offsets[j] + WIDTHS[j] * num_rows > length_) fail("broken offset table");
+    }
+    id_ = reinterpret_cast<const uint64_t*>(data_ + offsets[0u]);
+    father_id_ = reinterpret_cast<const uint64_t*>(data_ + offsets[1u]);
+    mother_id_ = reinterpret_cast<const uint64_t*>(data_ + offsets[2u]);
+    birth_year_ = reinterpret_cast<const int32_t*>(data_ + offsets[3u]);
+    location_ = reinterpret_cast<const int32_t*>(data_ + offsets[4u]);
+    capture_year_ = reinterpret_cast<const int32_t*>(data_ + offsets[5u]);
+}
+
+PedigreeFile::~PedigreeFile() {
+    unmap();
+}
+
+void PedigreeFile::unmap() noexcept {
+#ifndef _WIN32
+    if (data_ && length_ > 0u) {
+        ::munmap(const_cast<char*>(data_), length_);
+    }
+#endif
+    data_ = nullptr;
+}
+
+size_t PedigreeFile::find(const uint64_t id) const noexcept {
+    const auto it = std::lower_bound(id_, id_ + size_, id);
+    if (it == id_ + size_ || *it != id) return size_;
+    return static_cast<size_t>(it - id_);
+}
+
+} // namespace pbf
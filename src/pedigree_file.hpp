@@ -0,0 +1,111 @@
+/*! @file pedigree_file.hpp
+    @brief Interface of binary pedigree format
+*/
+#pragma once
+#ifndef PBT_PEDIGREE_FILE_HPP_
+#define PBT_PEDIGREE_FILE_HPP_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Columns of sample_family to be written in the binary format
+
+    The format is little-endian and consists of a 72-byte header
+    followed by fixed-width columns in the order of the offset table.
+    Rows are sorted by id, so that parents precede their children
+    and PedigreeFile::find() can use binary search.
+
+    offset | type         | content
+    ------ | ------------ | -------
+    0      | char[8]      | `"PBTPEDIG"`
+    8      | uint32       | format version (1)
+    12     | uint32       | number of columns (6)
+    16     | uint64       | number of rows N
+    24     | uint64[6]    | byte offset of each column from the beginning
+    ...    | uint64[N]    | id
+    ...    | uint64[N]    | father_id; 0 if unknown
+    ...    | uint64[N]    | mother_id; 0 if unknown
+    ...    | int32[N]     | birth_year
+    ...    | int32[N]     | location; -1 if not sampled
+    ...    | int32[N]     | capture_year; -1 if not sampled
+*/
+struct PedigreeColumns {
+    //! @cond
+    std::vector<uint64_t> id;
+    std::vector<uint64_t> father_id;
+    std::vector<uint64_t> mother_id;
+    std::vector<int32_t> birth_year;
+    std::vector<int32_t> location;
+    std::vector<int32_t> capture_year;
+    //! @endcond
+
+    //! number of rows
+    size_t size() const noexcept {return id.size();}
+    //! add a row
+    void push_back(uint64_t id_, uint64_t father_id_, uint64_t mother_id_,
+                   int32_t birth_year_, int32_t location_=-1, int32_t capture_year_=-1);
+    //! sort rows by id and write in the binary format
+    std::ostream& write(std::ostream&) const;
+};
+
+/*! @brief Read-only view of a binary pedigree file mapped into memory
+
+    Columns are accessed in place without parsing,
+    so that opening a file costs constant time regardless of its size.
+    Only little-endian hosts are supported.
+*/
+class PedigreeFile {
+  public:
+    //! map the file
+    explicit PedigreeFile(const std::string& path);
+    //! unmap the file
+    ~PedigreeFile();
+    PedigreeFile(const PedigreeFile&) = delete;
+    PedigreeFile& operator=(const PedigreeFile&) = delete;
+
+    //! number of rows
+    size_t size() const noexcept {return size_;}
+    //! row of an id; size() if not found
+    size_t find(uint64_t id) const noexcept;
+
+    //! @name Columns
+    //@{
+    uint64_t id(size_t row) const noexcept {return id_[row];}
+    uint64_t father_id(size_t row) const noexcept {return father_id_[row];}
+    uint64_t mother_id(size_t row) const noexcept {return mother_id_[row];}
+    int32_t birth_year(size_t row) const noexcept {return birth_year_[row];}
+    int32_t location(size_t row) const noexcept {return location_[row];}
+    int32_t capture_year(size_t row) const noexcept {return capture_year_[row];}
+    //@}
+
+  private:
+    //! release the mapping
+    void unmap() noexcept;
+
+    //! beginning of the file content
+    const char* data_ = nullptr;
+    //! size of the file in bytes
+    size_t length_ = 0u;
+    //! buffer used instead of mmap where it is not available
+    std::vector<char> buffer_;
+    //! number of rows
+    size_t size_ = 0u;
+    //! @cond
+    const uint64_t* id_ = nullptr;
+    const uint64_t* father_id_ = nullptr;
+    const uint64_t* mother_id_ = nullptr;
+    const int32_t* birth_year_ = nullptr;
+    const int32_t* location_ = nullptr;
+    const int32_t* capture_year_ = nullptr;
+    //! @endcond
+};
+
+} // namespace pbf
+
+#endif /* PBT_PEDIGREE_FILE_HPP_ */
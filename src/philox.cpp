@@ -0,0 +1,125 @@
+/*! @file philox.cpp
+    @brief Implementation of Philox class
+*/
+#include "philox.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+namespace pbf {
+
+namespace {
+
+//! @cond
+constexpr uint32_t MULTIPLIER_0 = 0xD2511F53u;
+constexpr uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+constexpr uint32_t WEYL_0 = 0x9E3779B9u;
+constexpr uint32_t WEYL_1 = 0xBB67AE85u;
+//! @endcond
+
+#if defined(__AVX512F__)
+//! 16 blocks in 512-bit registers
+struct Simd {
+    using vec = __m512i;
+    static constexpr size_t width = 16u;
+    static vec set1(uint32_t x) noexcept {return _mm512_set1_epi32(static_cast<int>(x));}
+    static vec iota(uint32_t x) noexcept {
+        return _mm512_add_epi32(set1(x), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+    static vec bit_xor(vec a, vec b) noexcept {return _mm512_xor_si512(a, b);}
+    //! 32x32->64 products of each lane split into high and low words
+    static void mulhilo(vec a, uint32_t m, vec* hi, vec* lo) noexcept {
+        // zero-masked forms: the unmasked ones have undefined sources
+        // that GCC 12 reports as -Wmaybe-uninitialized (https://gcc.gnu.org/PR105593)
+        constexpr __mmask8 all = 0xFFu;
+        const vec mv = set1(m);
+        const vec even = _mm512_maskz_mul_epu32(all, a, mv);
+        const vec odd = _mm512_maskz_mul_epu32(all, _mm512_maskz_srli_epi64(all, a, 32), mv);
+        *lo = _mm512_mask_blend_epi32(0xAAAAu, even, _mm512_maskz_slli_epi64(all, odd, 32));
+        *hi = _mm512_mask_blend_epi32(0xAAAAu, _mm512_maskz_srli_epi64(all, even, 32), odd);
+    }
+    static void store(uint32_t* p, vec a) noexcept {_mm512_storeu_si512(p, a);}
+};
+#elif defined(__AVX2__)
+//! 8 blocks in 256-bit registers
+struct Simd {
+    using vec = __m256i;
+    static constexpr size_t width = 8u;
+    static vec set1(uint32_t x) noexcept {return _mm256_set1_epi32(static_cast<int>(x));}
+    static vec iota(uint32_t x) noexcept {
+        return _mm256_add_epi32(set1(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    }
+    static vec bit_xor(vec a, vec b) noexcept {return _mm256_xor_si256(a, b);}
+    //! 32x32->64 products of each lane split into high and low words
+    static void mulhilo(vec a, uint32_t m, vec* hi, vec* lo) noexcept {
+        const vec mv = set1(m);
+        const vec even = _mm256_mul_epu32(a, mv);
+        const vec odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mv);
+        *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+    static void store(uint32_t* p, vec a) noexcept {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a);
+    }
+};
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+//! Philox4x32-10 of Simd::width consecutive counters at a time; return the number of blocks done
+size_t fill_simd(const Philox::block_type& counter, const Philox::key_type& key,
+                 const size_t num_blocks, Philox::result_type* first) noexcept {
+    constexpr size_t width = Simd::width;
+    uint32_t words[4u][width];
+    size_t b = 0u;
+    for (; b + width <= num_blocks; b += width) {
+        Simd::vec c0 = Simd::iota(counter[0u] + static_cast<uint32_t>(b));
+        Simd::vec c1 = Simd::set1(counter[1u]);
+        Simd::vec c2 = Simd::set1(counter[2u]);
+        Simd::vec c3 = Simd::set1(counter[3u]);
+        uint32_t k0 = key[0u];
+        uint32_t k1 = key[1u];
+        for (unsigned r=0u; r<10u; ++r) {
+            if (r > 0u) {
+                k0 += WEYL_0;
+                k1 += WEYL_1;
+            }
+            Simd::vec hi0, lo0, hi1, lo1;
+            Simd::mulhilo(c0, MULTIPLIER_0, &hi0, &lo0);
+            Simd::mulhilo(c2, MULTIPLIER_1, &hi1, &lo1);
+            c0 = Simd::bit_xor(Simd::bit_xor(hi1, c1), Simd::set1(k0));
+            c1 = lo1;
+            c2 = Simd::bit_xor(Simd::bit_xor(hi0, c3), Simd::set1(k1));
+            c3 = lo0;
+        }
+        Simd::store(words[0u], c0);
+        Simd::store(words[1u], c1);
+        Simd::store(words[2u], c2);
+        Simd::store(words[3u], c3);
+        Philox::result_type* out = first + 2u * b;
+        for (size_t j=0u; j<width; ++j) {
+            out[2u * j] = words[0u][j] | (static_cast<Philox::result_type>(words[1u][j]) << 32);
+            out[2u * j + 1u] = words[2u][j] | (static_cast<Philox::result_type>(words[3u][j]) << 32);
+        }
+    }
+    return b;
+}
+#endif
+
+} // namespace
+
+void Philox::fill(block_type counter, const key_type key, const size_t num_blocks, result_type* first) noexcept {
+    size_t b = 0u;
+#if defined(__AVX512F__) || defined(__AVX2__)
+    b = fill_simd(counter, key, num_blocks, first);
+    counter[0u] += static_cast<uint32_t>(b);
+#endif
+    for (; b<num_blocks; ++b) {
+        const auto block = bijection(counter, key);
+        ++counter[0u];
+        first[2u * b] = block[0u] | (static_cast<result_type>(block[1u]) << 32);
+        first[2u * b + 1u] = block[2u] | (static_cast<result_type>(block[3u]) << 32);
+    }
+}
+
+} // namespace pbf
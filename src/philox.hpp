@@ -0,0 +1,114 @@
+/*! @file philox.hpp
+    @brief Interface of Philox class
+*/
+#pragma once
+#ifndef PBT_PHILOX_HPP_
+#define PBT_PHILOX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <limits>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Counter-based random bit generator Philox4x32-10
+
+    Salmon et al. (2011) "Parallel random numbers: as easy as 1, 2, 3".
+    Each output block is a bijection of a 128-bit counter under a 64-bit key,
+    so that any number of independent streams can be created in constant time
+    from a key and the upper three counter words
+    without sharing state between threads.
+    The lowest counter word is incremented for each block of two outputs.
+    generate() fills an array with the same outputs as repeated calls,
+    computing blocks in parallel with AVX-512 or AVX2 if available.
+*/
+class Philox {
+  public:
+    //! Alias
+    using result_type = uint64_t;
+    //! Alias
+    using block_type = std::array<uint32_t, 4u>;
+    //! Alias
+    using key_type = std::array<uint32_t, 2u>;
+
+    //! stream 0 of a key
+    explicit Philox(uint64_t seed=0u) noexcept: Philox(seed, 0u, 0u, 0u) {}
+    //! stream identified by the upper three counter words
+    Philox(uint64_t seed, uint32_t c1, uint32_t c2, uint32_t c3) noexcept
+    : counter_{{0u, c1, c2, c3}},
+      key_{{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}} {}
+
+    //! generate a random number
+    result_type operator()() noexcept {
+        if (position_ == 0u) {
+            buffer_ = bijection(counter_, key_);
+            ++counter_[0u];
+        }
+        const auto lo = static_cast<result_type>(buffer_[position_]);
+        const auto hi = static_cast<result_type>(buffer_[position_ + 1u]);
+        position_ = (position_ + 2u) & 3u;
+        return lo | (hi << 32);
+    }
+    //! fill `n` outputs; the same as calling operator() `n` times
+    void generate(result_type* first, size_t n) noexcept {
+        size_t i = 0u;
+        for (; i < n && position_ != 0u; ++i) first[i] = (*this)();
+        const size_t num_blocks = (n - i) / 2u;
+        fill(counter_, key_, num_blocks, first + i);
+        counter_[0u] += static_cast<uint32_t>(num_blocks);
+        for (i += 2u * num_blocks; i < n; ++i) first[i] = (*this)();
+    }
+    //! skip z outputs
+    void discard(unsigned long long z) noexcept {
+        if (position_ != 0u && z > 0u) {
+            (*this)();
+            --z;
+        }
+        counter_[0u] += static_cast<uint32_t>(z / 2u);
+        if (z % 2u) (*this)();
+    }
+    //! minimum value
+    static constexpr result_type min() noexcept {return 0u;}
+    //! maximum value
+    static constexpr result_type max() noexcept {return std::numeric_limits<result_type>::max();}
+    //! name of the algorithm
+    static const char* name() noexcept {return "philox4x32-10";}
+
+    //! Philox4x32 with 10 rounds
+    static block_type bijection(block_type counter, key_type key) noexcept {
+        for (unsigned r=0u; r<10u; ++r) {
+            if (r > 0u) {
+                key[0u] += 0x9E3779B9u;
+                key[1u] += 0xBB67AE85u;
+            }
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * counter[0u];
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2u];
+            counter = {{
+                static_cast<uint32_t>(p1 >> 32) ^ counter[1u] ^ key[0u],
+                static_cast<uint32_t>(p1),
+                static_cast<uint32_t>(p0 >> 32) ^ counter[3u] ^ key[1u],
+                static_cast<uint32_t>(p0)
+            }};
+        }
+        return counter;
+    }
+    //! write outputs of `num_blocks` blocks from `counter` without changing state
+    static void fill(block_type counter, key_type key, size_t num_blocks, result_type* first) noexcept;
+
+  private:
+    //! input of the next block
+    block_type counter_;
+    //! key
+    key_type key_;
+    //! output of the current block
+    block_type buffer_ = {{0u, 0u, 0u, 0u}};
+    //! index of the next output in #buffer_; 0 if exhausted
+    unsigned position_ = 0u;
+};
+
+} // namespace pbf
+
+#endif /* PBT_PHILOX_HPP_ */
@@ -3,58 +3,368 @@
 */
 #include "population.hpp"
 #include "individual.hpp"
+#include "context.hpp"
+#include "pedigree.hpp"
+#include "pedigree_file.hpp"
+#include "alias_table.hpp"
+#include "parallel.hpp"
+#include "binary.hpp"
+#include "profile.hpp"
+#include "kernels.hpp"
+#include "random.hpp"
 
 #include <wtl/random.hpp>
 #include <wtl/debug.hpp>
 #include <wtl/iostr.hpp>
 #include <wtl/exception.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+#include <unordered_map>
+#include <stdexcept>
+#include <utility>
+
 namespace pbf {
 
-Population::Population(const size_t initial_size, std::random_device::result_type seed)
-: subpopulations_(4u), juveniles_subpops_(2u),
-  engine_(std::make_unique<URBG>(seed)) {
-    subpopulations_[0u].reserve(initial_size);
+static_assert(std::is_same<Population::handle_type, Pedigree::handle_type>{}, "");
+static_assert(std::is_same<Subpopulation::handle_type, Pedigree::handle_type>{}, "");
+
+namespace {
+
+//! Number of individuals sharing a random stream.
+//! Fixed to make results independent of the number of threads.
+constexpr size_t CHUNK_SIZE = 8192u;
+
+//! Number of age classes in demography
+constexpr size_t NUM_AGES = 80u;
+
+//! Number of chunks to cover n individuals
+inline size_t num_chunks(size_t n) noexcept {
+    return (n + CHUNK_SIZE - 1u) / CHUNK_SIZE;
+}
+
+//! Juveniles produced from a chunk or an age class of mothers
+/*! Mothers are indices in the subpopulation rather than handles,
+    which may be moved by Population::check_memory().
+*/
+struct Brood {
+    Families family;
+    uint_fast32_t num_eggs = 0u;
+};
+
+//! Draw counts of `n` trials into `k` categories of normalized `weights`
+/*! Conditional binomials are drawn in order, so that the cost is \f$O(k)\f$.
+*/
+template <class Count> inline
+void draw_multinomial(const size_t n, const double* weights, const size_t k,
+                      URBG& engine, Count* counts) {
+    size_t remaining = n;
+    double mass = 1.0;
+    for (size_t i=0u; i<k; ++i) {
+        if (i + 1u == k) {
+            counts[i] = static_cast<Count>(remaining);
+            break;
+        }
+        const double p = (mass > 0.0) ? std::min(1.0, weights[i] / mass) : 0.0;
+        const auto x = (remaining > 0u) ? std::binomial_distribution<size_t>(remaining, p)(engine) : size_t{0u};
+        counts[i] = static_cast<Count>(x);
+        remaining -= x;
+        mass -= weights[i];
+    }
+}
+
+} // namespace
+
+Population::Population(const size_t initial_size, const uint64_t seed,
+                       std::shared_ptr<const Context> context,
+                       const param_type& params)
+: subpopulations_(4u), juvenile_families_(2u),
+  age_counts_(subpopulations_.size(), std::vector<Demography::count_type>(NUM_AGES)),
+  demography_(subpopulations_.size(), NUM_AGES),
+  context_(context ? std::move(context) : std::make_shared<const Context>()),
+  params_(params),
+  pedigree_(std::make_unique<Pedigree>()),
+  seed_(seed) {
     const size_t half = initial_size / 2UL;
+    if (params_.COUNT_ONLY) {
+        male_counts_.assign(num_subpops(), std::vector<Demography::count_type>(NUM_AGES));
+        age_counts_[0u][4u] = static_cast<Demography::count_type>(initial_size);
+        male_counts_[0u][4u] = static_cast<Demography::count_type>(half);
+        return;
+    }
+    subpopulations_[0u].reserve(initial_size);
+    pedigree_->reserve(initial_size);
     for (size_t i=0; i<initial_size; ++i) {
-        subpopulations_[0u].emplace_back(std::make_shared<Individual>(i < half));
+        subpopulations_[0u].push_back(pedigree_->emplace(i < half), -4, i < half);
+        count_in(0u, -4);
+    }
+}
+
+namespace {
+
+//! Tag at the beginning of checkpoint files
+constexpr char CHECKPOINT_MAGIC[9] = "PBTCHKPT";
+//! Version of the checkpoint format
+constexpr uint32_t CHECKPOINT_VERSION = 6u;
+
+//! Check the header and read Context of a checkpoint
+std::shared_ptr<const Context> read_checkpoint_context(std::istream& ist) {
+    binary::read_magic(ist, CHECKPOINT_MAGIC);
+    if (binary::read<uint32_t>(ist) != CHECKPOINT_VERSION) {
+        throw std::runtime_error("unsupported version of checkpoint");
+    }
+    IndividualParams params;
+    params.RECRUITMENT_COEF = binary::read_double(ist);
+    params.CARRYING_CAPACITY = binary::read_double(ist);
+    params.NEGATIVE_BINOM_K = binary::read_double(ist);
+    std::istringstream json(binary::read_string(ist));
+    return std::make_shared<const Context>(params, json);
+}
+
+//! Write columns of Subpopulation
+void write_binary(std::ostream& ost, const Subpopulation& x) {
+    binary::write_vector(ost, x.handle);
+    binary::write_vector(ost, x.birth_year);
+    binary::write_vector(ost, x.is_male);
+}
+
+//! Read columns of Subpopulation
+void read_binary(std::istream& ist, Subpopulation* x) {
+    binary::read_vector(ist, &x->handle);
+    binary::read_vector(ist, &x->birth_year);
+    binary::read_vector(ist, &x->is_male);
+    if (x->birth_year.size() != x->size() || x->is_male.size() != x->size()) {
+        throw std::runtime_error("broken subpopulation in checkpoint");
     }
 }
 
+//! Write columns of Families
+void write_binary(std::ostream& ost, const Families& x) {
+    binary::write_vector(ost, x.mother);
+    binary::write_vector(ost, x.num_males);
+    binary::write_vector(ost, x.num_females);
+    binary::write_vector(ost, x.males);
+    for (const auto w: x.male_weights) binary::write_double(ost, w);
+    binary::write(ost, x.first_id);
+    binary::write_vector(ost, x.taken);
+    binary::write_vector(ost, x.handle);
+}
+
+//! Read columns of Families
+void read_binary(std::istream& ist, Families* x) {
+    binary::read_vector(ist, &x->mother);
+    binary::read_vector(ist, &x->num_males);
+    binary::read_vector(ist, &x->num_females);
+    binary::read_vector(ist, &x->males);
+    x->male_weights.resize(x->males.size());
+    for (auto& w: x->male_weights) w = binary::read_double(ist);
+    x->first_id = binary::read<Families::id_type>(ist);
+    binary::read_vector(ist, &x->taken);
+    binary::read_vector(ist, &x->handle);
+    if (x->num_males.size() != x->size() || x->num_females.size() != x->size()
+        || x->taken.size() > x->num_born()
+        || (!x->handle.empty() && x->handle.size() != x->num_born())) {
+        throw std::runtime_error("broken families in checkpoint");
+    }
+    x->father_table = nullptr;
+    if (!x->males.empty()) x->father_table = std::make_shared<const AliasTable>(x->male_weights);
+}
+
+} // namespace
+
+Population::Population(std::istream& ist, const uint64_t seed, const param_type& params)
+: context_(read_checkpoint_context(ist)),
+  params_(params),
+  pedigree_(std::make_unique<Pedigree>()),
+  seed_(seed) {
+    if ((binary::read<uint8_t>(ist) != 0u) != params_.COUNT_ONLY) {
+        throw std::runtime_error("checkpoint was written with another value of COUNT_ONLY");
+    }
+    if ((binary::read<uint8_t>(ist) != 0u) != params_.EAGER_JUVENILES) {
+        throw std::runtime_error("checkpoint was written with another value of EAGER_JUVENILES");
+    }
+    year_ = binary::read<int32_t>(ist);
+    pedigree_start_ = binary::read<int64_t>(ist);
+    pedigree_->read_binary(ist);
+    subpopulations_.resize(binary::read<uint32_t>(ist));
+    for (auto& x: subpopulations_) read_binary(ist, &x);
+    juvenile_families_.resize(binary::read<uint32_t>(ist));
+    for (auto& x: juvenile_families_) read_binary(ist, &x);
+    age_counts_.resize(num_subpops());
+    for (auto& x: age_counts_) binary::read_vector(ist, &x);
+    male_counts_.resize(binary::read<uint32_t>(ist));
+    for (auto& x: male_counts_) binary::read_vector(ist, &x);
+    if (male_counts_.empty() == params_.COUNT_ONLY) {
+        throw std::runtime_error("broken counts in checkpoint");
+    }
+    loc_year_samples_.resize(binary::read<uint32_t>(ist));
+    for (auto& year_samples: loc_year_samples_) {
+        const auto num_years = binary::read<uint32_t>(ist);
+        for (uint32_t i=0u; i<num_years; ++i) {
+            const auto year = binary::read<int32_t>(ist);
+            binary::read_vector(ist, &year_samples[year]);
+        }
+    }
+    demography_ = Demography::read_binary(ist);
+}
+
+Population::Population(const Population& other, std::unique_ptr<Pedigree> pedigree, const uint64_t seed,
+                       std::shared_ptr<const Context> context, const param_type& params)
+: subpopulations_(other.subpopulations_),
+  juvenile_families_(other.juvenile_families_),
+  age_counts_(other.age_counts_),
+  juveniles_demography_(other.juveniles_demography_),
+  male_counts_(other.male_counts_),
+  juvenile_males_(other.juvenile_males_),
+  loc_year_samples_(other.loc_year_samples_),
+  demography_(other.demography_),
+  context_(context ? std::move(context) : other.context_),
+  params_(params),
+  pedigree_(std::move(pedigree)),
+  pedigree_start_(other.pedigree_start_),
+  year_(other.year_),
+  seed_(seed) {}
+
 Population::~Population() = default;
 
+std::unique_ptr<Population> Population::fork(const uint64_t seed,
+                                             std::shared_ptr<const Context> context,
+                                             const param_type& params) {
+    auto pedigree = pedigree_->fork();
+    return std::unique_ptr<Population>(
+      new Population(*this, std::move(pedigree), seed, std::move(context), params));
+}
+
+std::ostream& Population::write_checkpoint(std::ostream& ost) const {
+    binary::write_magic(ost, CHECKPOINT_MAGIC);
+    binary::write(ost, CHECKPOINT_VERSION);
+    const auto& params = context_->param();
+    binary::write_double(ost, params.RECRUITMENT_COEF);
+    binary::write_double(ost, params.CARRYING_CAPACITY);
+    binary::write_double(ost, params.NEGATIVE_BINOM_K);
+    std::ostringstream json;
+    context_->write_json(json);
+    binary::write_string(ost, json.str());
+    binary::write(ost, static_cast<uint8_t>(params_.COUNT_ONLY));
+    binary::write(ost, static_cast<uint8_t>(params_.EAGER_JUVENILES));
+    binary::write(ost, static_cast<int32_t>(year_));
+    binary::write(ost, static_cast<int64_t>(pedigree_start_));
+    pedigree_->write_binary(ost);
+    binary::write(ost, static_cast<uint32_t>(subpopulations_.size()));
+    for (const auto& x: subpopulations_) write_binary(ost, x);
+    binary::write(ost, static_cast<uint32_t>(juvenile_families_.size()));
+    for (const auto& x: juvenile_families_) write_binary(ost, x);
+    for (const auto& x: age_counts_) binary::write_vector(ost, x);
+    binary::write(ost, static_cast<uint32_t>(male_counts_.size()));
+    for (const auto& x: male_counts_) binary::write_vector(ost, x);
+    binary::write(ost, static_cast<uint32_t>(loc_year_samples_.size()));
+    for (const auto& year_samples: loc_year_samples_) {
+        binary::write(ost, static_cast<uint32_t>(year_samples.size()));
+        for (const auto& ys: year_samples) {
+            binary::write(ost, static_cast<int32_t>(ys.first));
+            binary::write_vector(ost, ys.second);
+        }
+    }
+    demography_.write_binary(ost);
+    return ost;
+}
+
 void Population::run(const int_fast32_t simulating_duration,
                      const std::vector<size_t>& sample_size_adult,
                      const std::vector<size_t>& sample_size_juvenile,
-                     const int_fast32_t recording_duration) {
+                     const int_fast32_t recording_duration,
+                     const int_fast32_t pedigree_depth,
+                     const year_callback_type& on_year_end) {
     loc_year_samples_.resize(std::min(num_subpops(),
                                       std::max(sample_size_adult.size(),
                                                sample_size_juvenile.size())));
     auto recording_start = simulating_duration - recording_duration;
-    append_demography(3);
-    for (year_ = 1; year_ <= simulating_duration; ++year_) {
-        reproduce();
-        if (year_ == 1) subpopulations_[0u].clear();
-        append_demography(0);
-        survive();
-        if (year_ > recording_start) {
-            sample(&subpopulations_, sample_size_adult);
-            sample(&juveniles_subpops_, sample_size_juvenile);
+    const bool count_only = params_.COUNT_ONLY;
+    if (count_only) {
+        const auto is_positive = [](size_t x) {return x > 0u;};
+        if (std::any_of(sample_size_adult.begin(), sample_size_adult.end(), is_positive) ||
+            std::any_of(sample_size_juvenile.begin(), sample_size_juvenile.end(), is_positive)) {
+            throw std::runtime_error("Population: COUNT_ONLY requires zero sample sizes");
         }
-        migrate();
-        append_demography(3);
     }
+    if (pedigree_depth >= 0) {
+        pedigree_start_ = recording_start - pedigree_depth;
+    }
+    using Stage = Profile::Phase;
+    if (year_ == 0) append_demography(3);
+    while (year_ < simulating_duration) {
+        ++year_;
+        if (profile_) profile_->begin_year(static_cast<int32_t>(year_));
+        increment_age();
+        {
+            Profile::Scope scope(profile_, Stage::reproduce);
+            if (count_only) {
+                reproduce_counts();
+            } else {
+                reproduce();
+            }
+            if (year_ == 1) {
+                for (const auto h: subpopulations_[0u].handle) pedigree_->release(h);
+                subpopulations_[0u].clear();
+                std::fill(age_counts_[0u].begin(), age_counts_[0u].end(), 0u);
+                if (count_only) std::fill(male_counts_[0u].begin(), male_counts_[0u].end(), 0u);
+            }
+        }
+        {
+            Profile::Scope scope(profile_, Stage::census);
+            append_demography(0);
+        }
+        {
+            Profile::Scope scope(profile_, Stage::survive);
+            if (count_only) {
+                survive_counts();
+            } else {
+                survive();
+            }
+        }
+        if (year_ > recording_start && !count_only) {
+            Profile::Scope scope(profile_, Stage::sample);
+            sample(&subpopulations_, sample_size_adult, Phase::sample_adult, params_.SAMPLE_SELECTIVITY);
+            sample_juveniles(sample_size_juvenile);
+        }
+        {
+            Profile::Scope scope(profile_, Stage::migrate);
+            if (count_only) {
+                migrate_counts();
+            } else {
+                migrate();
+            }
+        }
+        {
+            Profile::Scope scope(profile_, Stage::census);
+            append_demography(3);
+        }
+        if (profile_) profile_->end_year(pedigree_->size());
+        // a branch stops sharing the segments once most of its frozen records are dead
+        if (pedigree_->num_frozen_vacant() > pedigree_->num_frozen() / 2u) compact_pedigree();
+        check_memory();
+        if (on_year_end) on_year_end(*this);
+    }
+}
+
+URBG Population::engine(const Phase phase, const uint_fast32_t location, const size_t index) const {
+    return URBG(seed_,
+                static_cast<uint32_t>(index),
+                (static_cast<uint32_t>(phase) << 24) | static_cast<uint32_t>(location),
+                static_cast<uint32_t>(year_));
 }
 
 void Population::reproduce() {
-    const auto num_breeding_places = static_cast<uint_fast32_t>(juveniles_subpops_.size());
+    const auto num_breeding_places = static_cast<uint_fast32_t>(juvenile_families_.size());
     juveniles_demography_.assign(4u, std::vector<uint_fast32_t>(num_breeding_places));
     size_t popsize = 0;
     for (uint_fast32_t loc=0u; loc<num_breeding_places; ++loc) {
         popsize += subpopulations_[loc].size();
     }
     const auto N = static_cast<double>(popsize);
-    const double density_effect = std::max(0.0, 1.0 - N / Individual::param().CARRYING_CAPACITY);
+    const double density_effect = std::max(0.0, 1.0 - N / context_->param().CARRYING_CAPACITY);
     for (uint_fast32_t loc=0u; loc<num_breeding_places; ++loc) {
         reproduce(loc, density_effect);
     }
@@ -62,177 +372,819 @@ void Population::reproduce() {
 
 void Population::reproduce(const uint_fast32_t location, const double density_effect) {
     const auto& adults = subpopulations_[location];
-    auto& juveniles = juveniles_subpops_[location];
+    auto& families = juvenile_families_[location];
     const size_t n = adults.size();
-    double female_biomass = 0.0;
-    std::vector<uint_fast32_t> male_indices;
+    // indices in the subpopulation until the handles are copied into the families
+    std::vector<handle_type> males;
     std::vector<double> fitnesses;
     const size_t num_males = (adults.size() / 5u) + (adults.size() / 10u);
-    male_indices.reserve(num_males);
+    males.reserve(num_males);
     fitnesses.reserve(num_males);
     for (uint_fast32_t i=0u; i<n; ++i) {
-        const auto& p = adults[i];
-        if (p->is_male()) {
-            male_indices.push_back(i);
-            fitnesses.push_back(p->weight(year_));
-        } else {
-            female_biomass += p->weight(year_);
+        if (adults.is_male[i]) {
+            males.push_back(static_cast<handle_type>(i));
+            fitnesses.push_back(context_->weight_at(year_ - adults.birth_year[i]));
+        }
+    }
+    if (males.size() == 0u) return;
+    const double d0 = context_->death_rate()[0u];
+    std::vector<Brood> broods;
+    if (params_.COHORT_RECRUITMENT) {
+        // indices of mothers for each age
+        std::vector<std::vector<uint32_t>> cohorts(context_->death_rate().size());
+        for (uint_fast32_t i=0u; i<n; ++i) {
+            if (!adults.is_male[i]) cohorts[year_ - adults.birth_year[i]].push_back(static_cast<uint32_t>(i));
+        }
+        const double k = context_->param().NEGATIVE_BINOM_K;
+        broods.resize(cohorts.size());
+        parallel_for(params_.NUM_THREADS, cohorts.size(), [&](const size_t age) {
+            const auto& mothers = cohorts[age];
+            if (mothers.empty()) return;
+            auto engine_cohort = engine(Phase::reproduce, location, age);
+            Brood& brood = broods[age];
+            const auto num_mothers = static_cast<uint_fast32_t>(mothers.size());
+            brood.num_eggs = context_->recruitment_at(static_cast<int_fast32_t>(age), num_mothers, density_effect, engine_cohort);
+            const auto num_juveniles = brood.num_eggs - std::binomial_distribution<uint_fast32_t>(brood.num_eggs, d0)(engine_cohort);
+            const auto num_boys = std::binomial_distribution<uint_fast32_t>(num_juveniles, 0.5)(engine_cohort);
+            // Poisson totals are split uniformly among mothers.
+            // NB(k) totals are split by Dirichlet-multinomial(k, ..., k)
+            // as if each mother had NB(k) juveniles; thinning by d0 keeps this form.
+            // Given the Dirichlet weights, boys and girls are independent multinomials,
+            // which are drawn by conditional binomials at a cost linear in mothers.
+            std::vector<double> weights(num_mothers, 1.0 / num_mothers);
+            if (k > 0.0) {
+                std::gamma_distribution<double> gamma(k, 1.0);
+                double total = 0.0;
+                for (auto& w: weights) total += (w = gamma(engine_cohort));
+                if (total > 0.0) {
+                    for (auto& w: weights) w /= total;
+                } else {
+                    weights.assign(num_mothers, 1.0 / num_mothers);
+                }
+            }
+            // indexed by the order in `mothers`
+            std::vector<uint32_t> boys(num_mothers), girls(num_mothers);
+            draw_multinomial(num_boys, weights.data(), num_mothers, engine_cohort, boys.data());
+            draw_multinomial(num_juveniles - num_boys, weights.data(), num_mothers, engine_cohort, girls.data());
+            for (uint_fast32_t m=0u; m<num_mothers; ++m) {
+                if (boys[m] + girls[m] > 0u) brood.family.push_back(mothers[m], boys[m], girls[m]);
+            }
+        });
+    } else {
+        const double factor = context_->recruitment_factor(density_effect);
+        broods.resize(num_chunks(n));
+        parallel_for(params_.NUM_THREADS, broods.size(), [&](const size_t chunk) {
+            auto engine_chunk = engine(Phase::reproduce, location, chunk);
+            Brood& brood = broods[chunk];
+            const size_t begin = chunk * CHUNK_SIZE;
+            const size_t end = std::min(n, begin + CHUNK_SIZE);
+            std::vector<double> means(end - begin);
+            fill_recruitment_means(adults.birth_year.data() + begin, end - begin, static_cast<int32_t>(year_),
+                                   factor, context_->weight_for_age().data(), means.data());
+            for (size_t i=begin; i<end; ++i) {
+                if (adults.is_male[i]) continue;
+                uint_fast32_t num_juveniles = context_->recruitment(means[i - begin], engine_chunk);
+                brood.num_eggs += num_juveniles;
+                num_juveniles -= std::binomial_distribution<uint_fast32_t>(num_juveniles, d0)(engine_chunk);
+                const auto num_boys = std::binomial_distribution<uint_fast32_t>(num_juveniles, 0.5)(engine_chunk);
+                if (num_juveniles > 0u) {
+                    brood.family.push_back(static_cast<uint32_t>(i), num_boys, num_juveniles - num_boys);
+                }
+            }
+        });
+    }
+    size_t num_juveniles = 0u;
+    size_t num_records = 0u;
+    for (const auto& brood: broods) {
+        juveniles_demography_[0u][location] += brood.num_eggs;
+        num_juveniles += brood.family.num_born();
+        num_records += brood.family.size();
+    }
+    juveniles_demography_[3u][location] += static_cast<uint_fast32_t>(num_juveniles);
+    if (profile_) profile_->count(Profile::Event::born, num_juveniles);
+    const bool is_recorded = (year_ >= pedigree_start_);
+    size_t extra = num_records * (sizeof(handle_type) + 2u * sizeof(uint32_t));
+    if (is_recorded) {
+        extra += males.size() * (sizeof(handle_type) + 2u * sizeof(double) + sizeof(AliasTable::result_type));
+    }
+    if (params_.EAGER_JUVENILES) {
+        extra += num_juveniles * (2u * sizeof(handle_type) + sizeof(Individual)
+                                  + sizeof(uint32_t) + sizeof(Pedigree::id_type));
+    }
+    // before copying handles, which may be moved by compaction
+    check_memory(extra);
+    // Individuals are not created until sample_juveniles() or migrate();
+    // the records hold a reference to each mother and candidate father meanwhile.
+    families.first_id = pedigree_->take_ids(num_juveniles);
+    if (is_recorded) {
+        for (auto& h: males) {
+            h = adults.handle[h];
+            pedigree_->retain(h);
+        }
+        families.father_table = std::make_shared<const AliasTable>(fitnesses);
+        families.males = std::move(males);
+        families.male_weights = std::move(fitnesses);
+    }
+    for (const auto& brood: broods) {
+        const auto& family = brood.family;
+        for (size_t r=0; r<family.size(); ++r) {
+            const auto mother = is_recorded ? adults.handle[family.mother[r]] : 0u;
+            families.push_back(mother, family.num_males[r], family.num_females[r]);
+            pedigree_->retain(mother);
         }
     }
-    if (male_indices.size() == 0u) return;
-    std::discrete_distribution<uint_fast32_t> mate_distr(fitnesses.begin(), fitnesses.end());
-    const double exp_recruitment = density_effect * Individual::param().RECRUITMENT_COEF * female_biomass;
-    juveniles.reserve(static_cast<size_t>(exp_recruitment * 1.1));
-    const double d0 = Individual::death_rate()[0u];
-    for (const auto& mother: adults) {
-        if (mother->is_male()) continue;
-        uint_fast32_t num_juveniles = mother->recruitment(year_, density_effect, *engine_);
-        juveniles_demography_[0u][location] += num_juveniles;
-        num_juveniles -= std::binomial_distribution<uint_fast32_t>(num_juveniles, d0)(*engine_);
-        juveniles_demography_[3u][location] += num_juveniles;
-        const auto num_boys = std::binomial_distribution<uint_fast32_t>(num_juveniles, 0.5)(*engine_);
-        for (uint_fast32_t j=0; j<num_juveniles; ++j) {
-            const auto& father = adults[male_indices[mate_distr(*engine_)]];
-            juveniles.emplace_back(std::make_shared<Individual>(father, mother, year_, j < num_boys));
+    if (!params_.EAGER_JUVENILES) return;
+    families.handle.reserve(num_juveniles);
+    uint64_t position = 0u;
+    for (size_t r=0; r<families.size(); ++r) {
+        const uint32_t size = families.num_males[r] + families.num_females[r];
+        for (uint32_t j=0u; j<size; ++j, ++position) {
+            families.handle.push_back(create_juvenile(location, r, position, j < families.num_males[r]));
         }
     }
 }
 
 void Population::survive() {
-    for (auto& individuals: subpopulations_) {
-        size_t n = individuals.size();
+    std::vector<std::vector<uint8_t>> is_dead(num_subpops());
+    if (params_.COHORT_SURVIVAL) {
+        parallel_for(params_.NUM_THREADS, num_subpops(), [this, &is_dead](const size_t loc) {
+            is_dead[loc] = draw_deaths_by_cohort(static_cast<uint_fast32_t>(loc));
+        });
+    } else {
+        for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+            const auto& individuals = subpopulations_[loc];
+            const size_t n = individuals.size();
+            auto& is_dead_loc = is_dead[loc];
+            is_dead_loc.resize(n);
+            parallel_for(params_.NUM_THREADS, num_chunks(n), [&, loc, n](const size_t chunk) {
+                auto engine_chunk = engine(Phase::survive, loc, chunk);
+                const size_t begin = chunk * CHUNK_SIZE;
+                const size_t end = std::min(n, begin + CHUNK_SIZE);
+                mark_deaths(individuals.birth_year.data() + begin, end - begin, static_cast<int32_t>(year_),
+                            context_->death_threshold().data(), engine_chunk, is_dead_loc.data() + begin);
+            });
+        }
+    }
+    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+        remove_dead(loc, is_dead[loc]);
+    }
+}
+
+std::vector<uint8_t> Population::draw_deaths_by_cohort(const uint_fast32_t location) const {
+    const auto& individuals = subpopulations_[location];
+    const auto& death_rate = context_->death_rate();
+    const size_t n = individuals.size();
+    // counting sort of indices by age
+    std::vector<size_t> offsets(death_rate.size() + 1u);
+    for (const auto birth_year: individuals.birth_year) {
+        ++offsets[year_ - birth_year + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> members(n);
+    {
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
         for (size_t i=0; i<n; ++i) {
-            auto& p = individuals[i];
-            if (p->is_dead(year_, *engine_)) {
-                p = std::move(individuals.back());
-                individuals.pop_back();
-                --n;
-                --i;
-            }
+            members[cursor[year_ - individuals.birth_year[i]]++] = i;
+        }
+    }
+    std::vector<uint8_t> is_dead(n, 0u);
+    for (size_t age=0u; age<death_rate.size(); ++age) {
+        const size_t begin = offsets[age];
+        const size_t cohort_size = offsets[age + 1u] - begin;
+        if (cohort_size == 0u) continue;
+        auto engine_cohort = engine(Phase::survive, location, age);
+        const size_t num_dead = std::binomial_distribution<size_t>(cohort_size, death_rate[age])(engine_cohort);
+        // partial Fisher-Yates for whichever of the dead or the survivors is smaller
+        const bool pick_dead = (num_dead <= cohort_size / 2u);
+        const size_t num_picked = pick_dead ? num_dead : cohort_size - num_dead;
+        auto cohort = members.begin() + static_cast<ptrdiff_t>(begin);
+        for (size_t j=0; j<num_picked; ++j) {
+            const auto k = j + bounded(engine_cohort, cohort_size - j);
+            std::swap(cohort[j], cohort[k]);
+        }
+        for (size_t j=0; j<cohort_size; ++j) {
+            is_dead[cohort[j]] = ((j < num_picked) == pick_dead);
         }
     }
+    return is_dead;
 }
 
-void Population::migrate() {
-    std::vector<size_t> subpopsizes(num_subpops());
-    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
-        subpopsizes[loc] = subpopulations_[loc].size();
+void Population::remove_dead(const uint_fast32_t location, const std::vector<uint8_t>& is_dead) {
+    auto& individuals = subpopulations_[location];
+    const size_t n = individuals.size();
+    size_t num_survivors = 0u;
+    for (size_t i=0; i<n; ++i) {
+        if (is_dead[i]) {
+            count_out(location, individuals.birth_year[i]);
+            pedigree_->release(individuals.handle[i]);
+        } else {
+            individuals.move(i, num_survivors++);
+        }
     }
+    individuals.resize(num_survivors);
+    if (profile_) profile_->count(Profile::Event::died, n - num_survivors);
+}
+
+void Population::migrate() {
+    size_t num_juveniles = 0u;
+    for (const auto& families: juvenile_families_) num_juveniles += families.num_individuals();
+    // before taking handles, which may be moved by compaction
+    check_memory(num_juveniles * (sizeof(handle_type) + sizeof(int32_t) + sizeof(uint8_t)
+                                  + sizeof(Individual) + sizeof(uint32_t) + sizeof(Pedigree::id_type)));
+    pedigree_->reserve(pedigree_->size() + num_juveniles);
+    std::vector<Subpopulation> immigrants(num_subpops());
+    std::vector<uint_fast32_t> destination;
+    size_t num_migrants = 0u;
     for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
         auto& individuals = subpopulations_[loc];
-        size_t n = subpopsizes[loc];
-        size_t num_immigrants = individuals.size() - n;
+        const size_t n = individuals.size();
+        if (params_.COHORT_MIGRATION) {
+            destination = draw_destinations_by_cohort(individuals.birth_year, loc, Phase::migrate);
+        } else {
+            destination.resize(n);
+            parallel_for(params_.NUM_THREADS, num_chunks(n), [&, loc, n](const size_t chunk) {
+                auto engine_chunk = engine(Phase::migrate, loc, chunk);
+                const size_t end = std::min(n, (chunk + 1u) * CHUNK_SIZE);
+                for (size_t i=chunk * CHUNK_SIZE; i<end; ++i) {
+                    destination[i] = context_->migrate_at(loc, year_ - individuals.birth_year[i], engine_chunk);
+                }
+            });
+        }
+        size_t num_stayers = 0u;
         for (size_t i=0; i<n; ++i) {
-            auto& p = individuals[i];
-            auto newloc = p->migrate(loc, year_, *engine_);
-            if (newloc == loc) continue;
-            subpopulations_[newloc].emplace_back(std::move(p));
-            p = std::move(individuals.back());
-            individuals.pop_back();
-            if (num_immigrants == 0u) {
-                --n;
-                --i;
+            if (destination[i] == loc) {
+                individuals.move(i, num_stayers++);
             } else {
-                --num_immigrants;
+                count_out(loc, individuals.birth_year[i]);
+                count_in(destination[i], individuals.birth_year[i]);
+                immigrants[destination[i]].push_back(individuals, i);
             }
         }
+        individuals.resize(num_stayers);
+        num_migrants += n - num_stayers;
     }
-    for (uint_fast32_t loc=0; loc<juveniles_subpops_.size(); ++loc) {
-        auto& juveniles = juveniles_subpops_[loc];
-        for (auto& p: juveniles) {
-            auto newloc = p->migrate(loc, year_, *engine_);
-            subpopulations_[newloc].emplace_back(std::move(p));
+    for (uint_fast32_t loc=0; loc<juvenile_families_.size(); ++loc) {
+        auto& families = juvenile_families_[loc];
+        const size_t n = families.num_individuals();
+        if (params_.COHORT_MIGRATION) {
+            const std::vector<int32_t> birth_year(n, static_cast<int32_t>(year_));
+            destination = draw_destinations_by_cohort(birth_year, loc, Phase::migrate_juvenile);
+        } else {
+            destination.resize(n);
+            parallel_for(params_.NUM_THREADS, num_chunks(n), [&, loc, n](const size_t chunk) {
+                auto engine_chunk = engine(Phase::migrate_juvenile, loc, chunk);
+                const size_t end = std::min(n, (chunk + 1u) * CHUNK_SIZE);
+                for (size_t i=chunk * CHUNK_SIZE; i<end; ++i) {
+                    destination[i] = context_->migrate_at(loc, 0, engine_chunk);
+                }
+            });
         }
-        juveniles.clear();
+        // materialize juveniles in the order of positions except those sampled
+        auto taken = families.taken.cbegin();
+        uint64_t position = 0u;
+        size_t i = 0u;
+        for (size_t r=0; r<families.size(); ++r) {
+            const uint32_t num_males = families.num_males[r];
+            const uint32_t size = num_males + families.num_females[r];
+            for (uint32_t j=0u; j<size; ++j, ++position) {
+                if (taken != families.taken.cend() && *taken == position) {
+                    ++taken;
+                    continue;
+                }
+                const bool is_male = (j < num_males);
+                const auto dst = destination[i++];
+                const auto handle = take_juvenile(loc, r, position, is_male);
+                count_in(dst, year_);
+                immigrants[dst].push_back(handle, year_, is_male);
+                num_migrants += (dst != loc);
+            }
+        }
+        release_families(loc);
     }
+    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+        subpopulations_[loc].append(immigrants[loc]);
+    }
+    if (profile_) profile_->count(Profile::Event::migrated, num_migrants);
 }
 
-void Population::sample(std::vector<std::vector<std::shared_ptr<Individual>>>* subpops,
-                        const std::vector<size_t>& sample_sizes) {
+std::vector<uint_fast32_t> Population::draw_destinations_by_cohort(
+  const std::vector<int32_t>& birth_year, const uint_fast32_t location, const Phase phase) const {
+    const auto& table = context_->migration();
+    const size_t num_locations = table.num_categories();
+    const size_t n = birth_year.size();
+    // counting sort of indices by age
+    std::vector<size_t> offsets(NUM_AGES + 1u);
+    for (const auto y: birth_year) {
+        ++offsets[year_ - y + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> members(n);
+    {
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i=0; i<n; ++i) {
+            members[cursor[year_ - birth_year[i]]++] = i;
+        }
+    }
+    std::vector<uint_fast32_t> destination(n);
+    std::vector<size_t> counts(num_locations);
+    for (size_t age=0u; age<NUM_AGES; ++age) {
+        const size_t begin = offsets[age];
+        const size_t cohort_size = offsets[age + 1u] - begin;
+        if (cohort_size == 0u) continue;
+        auto cohort = members.begin() + static_cast<ptrdiff_t>(begin);
+        const size_t row = age * num_locations + location;
+        const auto fixed = table.constant(row);
+        if (fixed != AliasTables::NONE) {
+            for (size_t j=0; j<cohort_size; ++j) destination[cohort[j]] = fixed;
+            continue;
+        }
+        auto engine_cohort = engine(phase, location, age);
+        draw_multinomial(cohort_size, table.weights(row), num_locations, engine_cohort, counts.data());
+        // partial Fisher-Yates for all but the largest destination
+        const auto largest = static_cast<uint_fast32_t>(
+          std::max_element(counts.begin(), counts.end()) - counts.begin());
+        size_t j = 0u;
+        for (uint_fast32_t dst=0u; dst<num_locations; ++dst) {
+            if (dst == largest) continue;
+            for (size_t c=0u; c<counts[dst]; ++c, ++j) {
+                const auto k = j + bounded(engine_cohort, cohort_size - j);
+                std::swap(cohort[j], cohort[k]);
+                destination[cohort[j]] = dst;
+            }
+        }
+        for (; j<cohort_size; ++j) destination[cohort[j]] = largest;
+    }
+    return destination;
+}
+
+void Population::reproduce_counts() {
+    const auto num_breeding_places = static_cast<uint_fast32_t>(juvenile_families_.size());
+    juveniles_demography_.assign(4u, std::vector<uint_fast32_t>(num_breeding_places));
+    juvenile_males_.assign(num_breeding_places, 0u);
+    uint_fast64_t popsize = 0u;
+    for (uint_fast32_t loc=0u; loc<num_breeding_places; ++loc) {
+        popsize += std::accumulate(age_counts_[loc].begin(), age_counts_[loc].end(), uint_fast64_t{0u});
+    }
+    const auto N = static_cast<double>(popsize);
+    const double density_effect = std::max(0.0, 1.0 - N / context_->param().CARRYING_CAPACITY);
+    const double d0 = context_->death_rate()[0u];
+    for (uint_fast32_t loc=0u; loc<num_breeding_places; ++loc) {
+        const auto& counts = age_counts_[loc];
+        const auto& males = male_counts_[loc];
+        if (std::all_of(males.begin(), males.end(), [](Demography::count_type x) {return x == 0u;})) continue;
+        uint_fast32_t num_eggs = 0u;
+        for (uint_fast32_t age=0u; age<NUM_AGES; ++age) {
+            const auto num_mothers = counts[age] - males[age];
+            if (num_mothers == 0u) continue;
+            auto engine_age = engine(Phase::reproduce, loc, age);
+            num_eggs += context_->recruitment_at(static_cast<int_fast32_t>(age), num_mothers, density_effect, engine_age);
+        }
+        auto engine_loc = engine(Phase::reproduce, loc, NUM_AGES);
+        const auto num_juveniles = num_eggs - std::binomial_distribution<uint_fast32_t>(num_eggs, d0)(engine_loc);
+        juvenile_males_[loc] = std::binomial_distribution<uint_fast32_t>(num_juveniles, 0.5)(engine_loc);
+        juveniles_demography_[0u][loc] = num_eggs;
+        juveniles_demography_[3u][loc] = num_juveniles;
+        if (profile_) profile_->count(Profile::Event::born, num_juveniles);
+    }
+}
+
+void Population::survive_counts() {
+    const auto& death_rate = context_->death_rate();
+    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+        auto& counts = age_counts_[loc];
+        auto& males = male_counts_[loc];
+        uint_fast64_t num_dead = 0u;
+        for (uint_fast32_t age=0u; age<NUM_AGES; ++age) {
+            if (counts[age] == 0u) continue;
+            auto engine_age = engine(Phase::survive, loc, age);
+            const auto num_females = counts[age] - males[age];
+            const auto dead_males = std::binomial_distribution<Demography::count_type>(males[age], death_rate[age])(engine_age);
+            const auto dead_females = std::binomial_distribution<Demography::count_type>(num_females, death_rate[age])(engine_age);
+            males[age] -= dead_males;
+            counts[age] -= dead_males + dead_females;
+            num_dead += dead_males + dead_females;
+        }
+        if (profile_) profile_->count(Profile::Event::died, num_dead);
+    }
+}
+
+void Population::migrate_counts() {
+    const auto& table = context_->migration();
+    const size_t num_locations = table.num_categories();
+    if (num_locations != num_subpops()) {
+        throw std::runtime_error("Population: migration matrices do not match the number of locations");
+    }
+    std::vector<std::vector<Demography::count_type>> next_counts(num_subpops(), std::vector<Demography::count_type>(NUM_AGES));
+    auto next_males = next_counts;
+    std::vector<Demography::count_type> to_males(num_locations), to_females(num_locations);
+    uint_fast64_t num_migrants = 0u;
+    // move `males` and `females` of an age from a location according to a row
+    auto distribute = [&](uint_fast32_t loc, size_t age, Demography::count_type males,
+                          Demography::count_type females, Phase phase) {
+        const size_t row = age * num_locations + loc;
+        const auto fixed = table.constant(row);
+        if (fixed != AliasTables::NONE) {
+            std::fill(to_males.begin(), to_males.end(), 0u);
+            std::fill(to_females.begin(), to_females.end(), 0u);
+            to_males[fixed] = males;
+            to_females[fixed] = females;
+        } else {
+            auto engine_age = engine(phase, loc, age);
+            draw_multinomial(males, table.weights(row), num_locations, engine_age, to_males.data());
+            draw_multinomial(females, table.weights(row), num_locations, engine_age, to_females.data());
+        }
+        for (size_t dst=0u; dst<num_locations; ++dst) {
+            next_counts[dst][age] += to_males[dst] + to_females[dst];
+            next_males[dst][age] += to_males[dst];
+            if (dst != loc) num_migrants += to_males[dst] + to_females[dst];
+        }
+    };
+    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+        for (size_t age=0u; age<NUM_AGES; ++age) {
+            const auto n = age_counts_[loc][age];
+            if (n == 0u) continue;
+            const auto males = male_counts_[loc][age];
+            distribute(loc, age, males, n - males, Phase::migrate);
+        }
+    }
+    for (uint_fast32_t loc=0u; loc<juvenile_males_.size(); ++loc) {
+        const auto n = static_cast<Demography::count_type>(juveniles_demography_[3u][loc]);
+        if (n == 0u) continue;
+        const auto males = static_cast<Demography::count_type>(juvenile_males_[loc]);
+        distribute(loc, 0u, males, n - males, Phase::migrate_juvenile);
+    }
+    age_counts_.swap(next_counts);
+    male_counts_.swap(next_males);
+    if (profile_) profile_->count(Profile::Event::migrated, num_migrants);
+}
+
+void Population::sample(std::vector<Subpopulation>* subpops,
+                        const std::vector<size_t>& sample_sizes, const Phase phase,
+                        const std::vector<double>& selectivity) {
     const auto max_loc = std::min(subpops->size(), sample_sizes.size());
+    const bool is_counted = (subpops == &subpopulations_);
+    const double max_selectivity = selectivity.empty() ? 1.0 :
+      *std::max_element(selectivity.begin(), selectivity.end());
+    auto selectivity_at = [this, &selectivity](const int_fast32_t birth_year) {
+        const auto age = static_cast<size_t>(year_ - birth_year);
+        return selectivity[std::min(age, selectivity.size() - 1u)];
+    };
     for (uint_fast32_t loc=0u; loc<max_loc; ++loc) {
         auto& individuals = subpops->at(loc);
-        std::shuffle(individuals.begin(), individuals.end(), *engine_);
-        const auto n = std::min(individuals.size(), sample_sizes[loc]);
-        std::vector<std::shared_ptr<Individual>>& sampled = loc_year_samples_[loc][year_];
+        auto engine_loc = engine(phase, loc);
+        // Partial Fisher-Yates moving the sampled to the back.
+        // With selectivity, candidates are accepted in proportion to it,
+        // which is equivalent to successive weighted draws without replacement.
+        size_t first = 0u;
+        size_t last = individuals.size();
+        size_t n = std::min(last, sample_sizes[loc]);
+        size_t num_rejected = 0u;
+        std::vector<handle_type>& sampled = loc_year_samples_[loc][year_];
         sampled.reserve(sampled.size() + n);
-        for (size_t i=0; i<n; ++i) {
-            sampled.emplace_back(std::move(individuals.back()));
+        while (n > 0u) {
+            const auto k = first + bounded(engine_loc, last - first);
+            if (!selectivity.empty()) {
+                const double s = selectivity_at(individuals.birth_year[k]);
+                if (s <= 0.0 || s < max_selectivity * canonical(engine_loc)) {
+                    if (++num_rejected > 64u * (last - first)) {
+                        // exclude zero-selectivity individuals to guarantee termination
+                        for (size_t i=first; i<last; ++i) {
+                            if (selectivity_at(individuals.birth_year[i]) <= 0.0) {
+                                individuals.swap(i, first++);
+                            }
+                        }
+                        n = std::min(n, last - first);
+                        num_rejected = 0u;
+                    }
+                    continue;
+                }
+            }
+            individuals.swap(k, --last);
+            --n;
+        }
+        for (size_t i=individuals.size(); i>last; --i) {
+            sampled.emplace_back(individuals.handle.back());
+            if (is_counted) count_out(loc, individuals.birth_year.back());
             individuals.pop_back();
         }
     }
 }
 
+void Population::sample_juveniles(const std::vector<size_t>& sample_sizes) {
+    const auto max_loc = std::min(juvenile_families_.size(), sample_sizes.size());
+    for (uint_fast32_t loc=0u; loc<max_loc; ++loc) {
+        auto& families = juvenile_families_[loc];
+        auto engine_loc = engine(Phase::sample_juvenile, loc);
+        size_t last = families.num_individuals();
+        size_t n = std::min(last, sample_sizes[loc]);
+        std::vector<handle_type>& sampled = loc_year_samples_[loc][year_];
+        if (n == 0u) continue;
+        sampled.reserve(sampled.size() + n);
+        // Partial Fisher-Yates over positions in order of birth;
+        // only the positions overwritten by swaps are stored.
+        std::unordered_map<size_t, size_t> swapped;
+        auto at = [&swapped](const size_t i) {
+            const auto it = swapped.find(i);
+            return (it == swapped.end()) ? i : it->second;
+        };
+        std::vector<std::pair<size_t, size_t>> picked;  // (position, order)
+        picked.reserve(n);
+        for (size_t order=0u; order<n; ++order) {
+            const auto k = bounded(engine_loc, last);
+            picked.emplace_back(at(k), order);
+            swapped[k] = at(--last);
+        }
+        // skip the positions taken before
+        for (auto& p: picked) {
+            for (const auto t: families.taken) {
+                if (t > p.first) break;
+                ++p.first;
+            }
+        }
+        // find the records of the sorted positions in a single pass
+        std::sort(picked.begin(), picked.end());
+        struct Pick {size_t record; uint64_t position; bool is_male;};
+        std::vector<Pick> picks(n);
+        size_t r = 0u;
+        size_t offset = 0u;
+        for (const auto& p: picked) {
+            while (p.first >= offset + families.num_males[r] + families.num_females[r]) {
+                offset += families.num_males[r] + families.num_females[r];
+                ++r;
+            }
+            picks[p.second] = Pick{r, p.first, p.first - offset < families.num_males[r]};
+        }
+        for (const auto& x: picks) {
+            sampled.emplace_back(take_juvenile(loc, x.record, x.position, x.is_male));
+        }
+        const auto middle = static_cast<ptrdiff_t>(families.taken.size());
+        for (const auto& p: picked) families.taken.push_back(p.first);
+        std::inplace_merge(families.taken.begin(), families.taken.begin() + middle, families.taken.end());
+    }
+}
+
+Population::handle_type Population::create_juvenile(const uint_fast32_t location, const size_t record,
+                                                    const uint64_t position, const bool is_male) {
+    const auto& families = juvenile_families_[location];
+    handle_type father = 0u;
+    if (families.father_table) {
+        auto engine_juvenile = engine(Phase::mate, location, position);
+        father = families.males[(*families.father_table)(engine_juvenile)];
+    }
+    return pedigree_->emplace(father, families.mother[record], year_, is_male, families.first_id + position);
+}
+
+Population::handle_type Population::take_juvenile(const uint_fast32_t location, const size_t record,
+                                                  const uint64_t position, const bool is_male) {
+    auto& created = juvenile_families_[location].handle;
+    if (created.empty()) return create_juvenile(location, record, position, is_male);
+    return std::exchange(created[position], 0u);
+}
+
+void Population::release_families(const uint_fast32_t location) {
+    auto& families = juvenile_families_[location];
+    for (const auto h: families.mother) pedigree_->release(h);
+    for (const auto h: families.males) pedigree_->release(h);
+    families.clear();
+}
+
 std::ostream& Population::write_sample_family(std::ostream& ost) const {
     if (loc_year_samples_.empty() || loc_year_samples_[0u].empty()) return ost;
     wtl::join(Individual::names(), ost, "\t") << "\tlocation\tcapture_year\n";
-    std::unordered_map<const Individual*, uint_fast32_t> ids;
-    ids.emplace(nullptr, 0u);
+    // capture_year is negative for ancestors that are not sampled
+    struct Row {handle_type handle; uint_fast32_t location; int_fast32_t capture_year;};
+    std::vector<Row> rows;
+    std::vector<handle_type> samples;
     for (uint_fast32_t loc=0u; loc<loc_year_samples_.size(); ++loc) {
-        const auto& year_samples = loc_year_samples_.at(loc);
-        for (const auto& ys: year_samples) {
-            for (const auto& p: ys.second) {
-                ids.emplace(p.get(), static_cast<uint_fast32_t>(ids.size()));
+        for (const auto& ys: loc_year_samples_[loc]) {
+            for (const auto p: ys.second) {
+                rows.push_back(Row{p, loc, ys.first});
+                samples.push_back(p);
             }
         }
-        for (const auto& ys: year_samples) {
-            for (const auto& p: ys.second) {
-                p->trace_back(ost, &ids, loc, ys.first);
-            }
+    }
+    for (const auto p: pedigree_->collect_ancestors(samples)) {
+        rows.push_back(Row{p, 0u, -1});
+    }
+    // serial IDs put parents before their children as in the binary format
+    const Pedigree& pedigree = *pedigree_;
+    std::sort(rows.begin(), rows.end(), [&pedigree](const Row& x, const Row& y) {
+        return pedigree.id(x.handle) < pedigree.id(y.handle);
+    });
+    for (const auto& row: rows) {
+        pedigree.write(ost, row.handle);
+        if (row.capture_year >= 0) {
+            ost << "\t" << row.location << "\t" << row.capture_year << "\n";
+        } else {
+            ost << "\t\t\n";
         }
     }
     return ost;
 }
 
-std::vector<std::vector<uint_fast32_t>> Population::count(const int_fast32_t season) const {
-    std::vector<std::vector<uint_fast32_t>> counter(num_subpops(), std::vector<uint_fast32_t>(80u));
-    if (!juveniles_demography_.empty()) {
-        const auto& jd_season = juveniles_demography_.at(season);
-        for (uint_fast32_t loc=0; loc<jd_season.size(); ++loc) {
-            counter[loc][0u] += jd_season[loc];
+std::ostream& Population::write_sample_family_binary(std::ostream& ost) const {
+    const Pedigree& pedigree = *pedigree_;
+    PedigreeColumns columns;
+    auto push_back = [&pedigree, &columns](handle_type p, int32_t loc, int32_t year) {
+        const auto& x = pedigree[p];
+        columns.push_back(pedigree.id(p), pedigree.id(x.father()), pedigree.id(x.mother()),
+                          static_cast<int32_t>(x.birth_year()), loc, year);
+    };
+    std::vector<handle_type> samples;
+    for (uint_fast32_t loc=0u; loc<loc_year_samples_.size(); ++loc) {
+        for (const auto& ys: loc_year_samples_[loc]) {
+            for (const auto p: ys.second) {
+                push_back(p, static_cast<int32_t>(loc), static_cast<int32_t>(ys.first));
+                samples.push_back(p);
+            }
         }
     }
-    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
-        auto& counter_loc = counter[loc];
-        for (const auto& p: subpopulations_[loc]) {
-            ++counter_loc[year_ - p->birth_year()];
-        }
+    for (const auto p: pedigree.collect_ancestors(samples)) {
+        push_back(p, -1, -1);
     }
-    return counter;
+    return columns.write(ost);
 }
 
-void Population::append_demography(const int_fast32_t season) {
-    demography_.emplace_hint(
-      demography_.end(),
-      std::pair<int_fast32_t, int_fast32_t>(year_, season),
-      count(season)
-    );
+std::vector<std::string> Population::summary_names() {
+    return {"biomass", "age_mean", "age_var", "po_pairs", "hs_pairs", "fs_pairs"};
 }
 
-std::ostream& Population::write_demography(std::ostream& ost) const {
-    ost << "year\tseason\tlocation\tage\tcount\n";
-    for (const auto& time_structure: demography_) {
-        const auto time = time_structure.first;
-        for (uint_fast32_t loc=0; loc<num_subpops(); ++loc) {
-            const auto structure = time_structure.second[loc];
-            for (uint_fast32_t age=0u; age<structure.size(); ++age) {
-                if (structure[age] == 0u) continue;
-                ost << time.first << "\t" << time.second << "\t"
-                    << loc << "\t"
-                    << age << "\t"
-                    << structure[age] << "\n";
+std::ostream& Population::write_summary(std::ostream& ost, const std::vector<std::string>& statistics,
+                                        const std::string& prefix) const {
+    const auto num_breeding_places = juvenile_families_.size();
+    std::vector<uint_fast64_t> kin_pairs;
+    for (const auto& stat: statistics) {
+        if (stat == "biomass") {
+            // individuals at breeding places just after reproduction
+            for (size_t t=0u; t<demography_.num_times(); ++t) {
+                if (demography_.season(t) != 0) continue;
+                double biomass = 0.0;
+                for (size_t loc=0u; loc<num_breeding_places; ++loc) {
+                    const auto structure = demography_.counts(t, loc);
+                    for (uint_fast32_t age=1u; age<demography_.num_ages(); ++age) {
+                        biomass += structure[age] * context_->weight_at(age);
+                    }
+                }
+                ost << prefix << stat << "\t" << demography_.year(t) << "\t" << biomass << "\n";
+            }
+        } else if (stat == "age_mean" || stat == "age_var") {
+            // individuals older than 0 at the end of each year
+            for (size_t t=0u; t<demography_.num_times(); ++t) {
+                if (demography_.season(t) != 3) continue;
+                double n = 0.0, sum = 0.0, sum_sq = 0.0;
+                for (size_t loc=0u; loc<demography_.num_locations(); ++loc) {
+                    const auto structure = demography_.counts(t, loc);
+                    for (uint_fast32_t age=1u; age<demography_.num_ages(); ++age) {
+                        n += structure[age];
+                        sum += static_cast<double>(structure[age]) * age;
+                        sum_sq += static_cast<double>(structure[age]) * age * age;
+                    }
+                }
+                if (n == 0.0) continue;
+                const double mean = sum / n;
+                const double value = (stat == "age_mean") ? mean : sum_sq / n - mean * mean;
+                ost << prefix << stat << "\t" << demography_.year(t) << "\t" << value << "\n";
             }
+        } else if (stat == "po_pairs" || stat == "hs_pairs" || stat == "fs_pairs") {
+            if (kin_pairs.empty()) kin_pairs = count_kin_pairs();
+            const size_t i = (stat == "po_pairs") ? 0u : (stat == "hs_pairs") ? 1u : 2u;
+            ost << prefix << stat << "\t\t" << kin_pairs[i] << "\n";
+        } else {
+            throw std::runtime_error("unknown summary statistic: " + stat);
         }
     }
     return ost;
 }
 
-std::ostream& Population::write(std::ostream& ost) const {
-    for (const auto& individuals: juveniles_subpops_) {
-        for (const auto& p: individuals) {ost << *p << "\n";}
+std::vector<uint_fast64_t> Population::count_kin_pairs() const {
+    const Pedigree& pedigree = *pedigree_;
+    std::unordered_set<handle_type> sampled;
+    std::unordered_map<handle_type, uint_fast64_t> mothers, fathers;
+    std::map<std::pair<handle_type, handle_type>, uint_fast64_t> couples;
+    for (const auto& year_samples: loc_year_samples_) {
+        for (const auto& ys: year_samples) {
+            for (const auto h: ys.second) {
+                sampled.insert(h);
+                const auto& x = pedigree[h];
+                if (x.is_first_gen()) continue;
+                ++fathers[x.father()];
+                ++mothers[x.mother()];
+                ++couples[{x.father(), x.mother()}];
+            }
+        }
+    }
+    auto num_pairs = [](const uint_fast64_t n) {return n * (n - 1u) / 2u;};
+    uint_fast64_t po = 0u, maternal = 0u, paternal = 0u, full = 0u;
+    for (const auto& p: fathers) {
+        paternal += num_pairs(p.second);
+        if (sampled.count(p.first)) po += p.second;
+    }
+    for (const auto& p: mothers) {
+        maternal += num_pairs(p.second);
+        if (sampled.count(p.first)) po += p.second;
+    }
+    for (const auto& p: couples) {
+        full += num_pairs(p.second);
+    }
+    return {po, maternal + paternal - 2u * full, full};
+}
+
+MemoryUsage Population::memory_usage() const noexcept {
+    MemoryUsage usage;
+    for (const auto& x: subpopulations_) usage.individuals += x.bytes();
+    for (const auto& x: juvenile_families_) usage.juveniles += x.bytes();
+    for (const auto& year_samples: loc_year_samples_) {
+        for (const auto& ys: year_samples) {
+            usage.samples += sizeof(ys) + ys.second.capacity() * sizeof(handle_type);
+        }
     }
+    usage.pedigree = pedigree_->bytes();
+    return usage;
+}
+
+void Population::check_memory(const size_t extra) {
+    if (params_.MAX_MEMORY <= 0.0) return;
+    constexpr double MiB = 1024.0 * 1024.0;
+    const double budget = params_.MAX_MEMORY * MiB;
+    auto usage = memory_usage();
+    // leave some room for temporary containers
+    if (static_cast<double>(usage.total() + extra) < 0.9 * budget) return;
+    if (pedigree_->num_vacant() > 0u) {
+        compact_pedigree();
+        usage = memory_usage();
+    }
+    if (static_cast<double>(usage.total() + extra) < budget) return;
+    std::ostringstream oss;
+    oss.precision(4);
+    oss << "Population: memory budget exceeded in year " << year_
+        << ": individuals " << usage.individuals / MiB << " MiB"
+        << ", juveniles " << usage.juveniles / MiB << " MiB"
+        << ", samples " << usage.samples / MiB << " MiB"
+        << ", pedigree " << usage.pedigree / MiB << " MiB"
+        << " (" << pedigree_->size() << " records)"
+        << ", next allocation " << extra / MiB << " MiB"
+        << " > max_memory " << params_.MAX_MEMORY << " MiB;"
+        << " reduce carrying_capacity or recruitment, or set pedigree_depth";
+    throw std::runtime_error(oss.str());
+}
+
+void Population::compact_pedigree() {
+    const auto moved = pedigree_->compact();
+    auto remap = [&moved](handle_type& h) {h = moved[h];};
+    for (auto& x: subpopulations_) {
+        for (auto& h: x.handle) remap(h);
+    }
+    for (auto& x: juvenile_families_) {
+        for (auto& h: x.mother) remap(h);
+        for (auto& h: x.males) remap(h);
+        for (auto& h: x.handle) remap(h);
+    }
+    for (auto& year_samples: loc_year_samples_) {
+        for (auto& ys: year_samples) {
+            for (auto& h: ys.second) remap(h);
+        }
+    }
+}
+
+void Population::increment_age() {
+    // nobody survives the last age class
+    for (auto& counter_loc: age_counts_) {
+        std::copy_backward(counter_loc.begin(), counter_loc.end() - 1, counter_loc.end());
+        counter_loc[0u] = 0u;
+    }
+    for (auto& counter_loc: male_counts_) {
+        std::copy_backward(counter_loc.begin(), counter_loc.end() - 1, counter_loc.end());
+        counter_loc[0u] = 0u;
+    }
+}
+
+void Population::append_demography(const int_fast32_t season) {
+    Demography census(num_subpops(), NUM_AGES);
+    Demography& target = demography_sink_ ? census : demography_;
+    auto counts = target.append(year_, season);
+    for (uint_fast32_t loc=0u; loc<num_subpops(); ++loc) {
+        std::copy(age_counts_[loc].begin(), age_counts_[loc].end(), counts + loc * NUM_AGES);
+    }
+    if (!juveniles_demography_.empty()) {
+        const auto& jd_season = juveniles_demography_.at(season);
+        for (uint_fast32_t loc=0; loc<jd_season.size(); ++loc) {
+            counts[loc * NUM_AGES] += static_cast<Demography::count_type>(jd_season[loc]);
+        }
+    }
+    if (demography_sink_) demography_sink_(census);
+}
+
+std::ostream& Population::write_demography(std::ostream& ost) const {
+    return demography_.write(ost);
+}
+
+std::ostream& Population::write_demography_binary(std::ostream& ost) const {
+    return demography_.write_binary(ost);
+}
+
+std::ostream& Population::write(std::ostream& ost) const {
     for (const auto& individuals: subpopulations_) {
-        for (const auto& p: individuals) {ost << *p << "\n";}
+        for (const auto p: individuals.handle) {ost << p << "\t" << (*pedigree_)[p] << "\n";}
     }
     return ost;
 }
@@ -6,44 +6,203 @@
 #define PBT_POPULATION_HPP_
 
 #include "random_fwd.hpp"
+#include "subpopulation.hpp"
+#include "demography.hpp"
 
 #include <cstdint>
 #include <iosfwd>
+#include <string>
 #include <vector>
 #include <list>
 #include <map>
 #include <memory>
+#include <functional>
+#include <limits>
 
 /////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
 
 namespace pbf {
 
-class Individual;
+class Pedigree;
+class Context;
+class Profile;
+
+//! @brief Parameters for Population class (command-line)
+/*! @ingroup params
+*/
+struct PopulationParams {
+    //! @ingroup params
+    //@{
+    //! Draw the number of deaths per (location, age) in survive()
+    bool COHORT_SURVIVAL = false;
+    //! Draw the number of migrants to each destination per (location, age) in migrate()
+    bool COHORT_MIGRATION = false;
+    //! Draw the number of juveniles per (location, age of mothers) in reproduce()
+    bool COHORT_RECRUITMENT = false;
+    //! Number of threads; results do not depend on it
+    unsigned NUM_THREADS = 1u;
+    //! Relative probability of adults being sampled for each age;
+    //! the last value is used for older ages, and uniform if empty
+    std::vector<double> SAMPLE_SELECTIVITY = {};
+    //! Memory budget of a replicate in MiB; unlimited if not positive
+    double MAX_MEMORY = 0.0;
+    //! Track only counts for each (location, age, sex) without individuals;
+    //! sample sizes must be zero
+    bool COUNT_ONLY = false;
+    //! Create each juvenile at birth instead of keeping family records
+    //! until it is sampled or migrates; results are identical with more memory
+    bool EAGER_JUVENILES = false;
+    //@}
+};
+
+//! @brief Bytes allocated by a Population; see Population::memory_usage()
+struct MemoryUsage {
+    //! @cond
+    size_t individuals = 0u;
+    size_t juveniles = 0u;
+    size_t samples = 0u;
+    size_t pedigree = 0u;
+    //! @endcond
+    //! sum of all
+    size_t total() const noexcept {return individuals + juveniles + samples + pedigree;}
+};
 
 /*! @brief Population class
 */
 class Population {
   public:
+    //! Alias
+    using param_type = PopulationParams;
+    //! Alias of Pedigree::handle_type
+    using handle_type = uint32_t;
+    //! Receiver of each census as a Demography holding only it
+    using demography_sink_type = std::function<void(const Demography&)>;
     //! constructor
-    Population(const size_t initial_size, std::random_device::result_type seed);
+    /*! @param context Parameters and tables; default values if nullptr
+    */
+    Population(const size_t initial_size, const uint64_t seed,
+               std::shared_ptr<const Context> context=nullptr,
+               const param_type& params=param_type{});
+    //! restore the state written by write_checkpoint()
+    /*! Random streams after restoration are keyed by `seed`,
+        so that the original seed continues the original run exactly
+        and other seeds branch off independent futures.
+        PopulationParams::COUNT_ONLY and PopulationParams::EAGER_JUVENILES
+        must be the same as when it was written; others may differ as in fork().
+    */
+    Population(std::istream& checkpoint, const uint64_t seed,
+               const param_type& params=param_type{});
     //! destructor
     ~Population();
 
+    //! Called at the end of each year
+    using year_callback_type = std::function<void(const Population&)>;
+
     //! main iteration
+    /*! Simulation continues from year() to `simulating_duration`.
+        @param pedigree_depth Parents are recorded only for individuals born
+                              in or after `pedigree_depth` years before recording.
+                              Negative value means unlimited.
+        @param on_year_end Called after each year, e.g., to write a checkpoint
+    */
     void run(const int_fast32_t simulating_duration,
              const std::vector<size_t>& sample_size_adult={1u, 1u},
              const std::vector<size_t>& sample_size_juvenile={1u,1u},
-             const int_fast32_t recording_duration=1);
+             const int_fast32_t recording_duration=1,
+             const int_fast32_t pedigree_depth=-1,
+             const year_callback_type& on_year_end=nullptr);
+
+    //! time each phase of run() into `profile` until nullptr is set
+    /*! Individuals born, dead, and migrated and the pedigree size
+        are also recorded for each year.
+        The profile must outlive the runs; it is not inherited by fork().
+    */
+    void set_profile(Profile* profile) noexcept {profile_ = profile;}
+
+    //! clone the current state as an independent branch
+    /*! The pedigree so far is frozen and shared with the branch
+        instead of being copied; see Pedigree::fork().
+        The branch does not inherit the demography sink.
+        @param seed Key of random streams of the branch;
+                    the same seed as this continues identically
+        @param context Parameters and tables of the branch,
+                       e.g., for another fishing scenario; same as this if nullptr
+        @param params Parameters of the branch, e.g., sample selectivity
+    */
+    std::unique_ptr<Population> fork(const uint64_t seed,
+                                     std::shared_ptr<const Context> context,
+                                     const param_type& params);
+    //! fork() with the same context and parameters
+    std::unique_ptr<Population> fork(const uint64_t seed) {
+        return fork(seed, context_, params_);
+    }
+
+    //! write the whole state in binary to be restored by the constructor
+    /*! Context is included, whereas PopulationParams and the sink are not,
+        except for the flags checked on restoration.
+        Censuses already sent to the sink are not included either,
+        so that the restored run streams only those of the following years.
+    */
+    std::ostream& write_checkpoint(std::ostream&) const;
+    //! last simulated year; 0 before run()
+    int_fast32_t year() const noexcept {return year_;}
+    //! bytes allocated for individuals, juveniles, samples, and pedigree records
+    /*! Capacities of the containers are counted without allocator overhead.
+        Pedigree segments frozen by fork() are counted by every branch
+        until it copies the records in use and drops the segments,
+        which happens once more than half of its frozen records are dead.
+    */
+    MemoryUsage memory_usage() const noexcept;
+
+    //! Send each census to `sink` as soon as it is taken instead of keeping it
+    /*! Memory usage is then constant in the number of years,
+        but write_demography() and write_summary() see no census.
+        A no-op function discards them, and nullptr restores the default.
+    */
+    void set_demography_sink(demography_sink_type sink) {demography_sink_ = std::move(sink);}
 
-    //! Construct and write tree from samples
+    /*! @brief Construct and write tree from samples
+
+        Samples and their ancestors are written in ascending order of ID,
+        so that parents precede their children.
+        IDs are 64-bit serial numbers given at birth,
+        which are sparse because most individuals are not written.
+        Ancestors that are not sampled have empty location and capture_year.
+    */
     std::ostream& write_sample_family(std::ostream& ost) const;
-    //! write #demography_
+    //! write_sample_family() in the binary format of PedigreeColumns
+    std::ostream& write_sample_family_binary(std::ostream& ost) const;
+    //! write #demography_ in TSV
     std::ostream& write_demography(std::ostream&) const;
+    //! write #demography_ in the binary format of Demography
+    std::ostream& write_demography_binary(std::ostream&) const;
+    //! write summary statistics in rows of `prefix`, statistic, year, value
+    std::ostream& write_summary(std::ostream&, const std::vector<std::string>& statistics,
+                                const std::string& prefix="") const;
+    //! names of statistics available in write_summary()
+    static std::vector<std::string> summary_names();
     //! write
     std::ostream& write(std::ostream&) const;
     friend std::ostream& operator<<(std::ostream&, const Population&);
 
   private:
+    //! copy the state of `other` except for the arguments
+    Population(const Population& other, std::unique_ptr<Pedigree> pedigree, const uint64_t seed,
+               std::shared_ptr<const Context> context, const param_type& params);
+
+    //! Stages of a year to derive independent random streams
+    enum class Phase: uint32_t {
+        reproduce,
+        survive,
+        sample_adult,
+        sample_juvenile,
+        migrate,
+        migrate_juvenile,
+        mate,
+    };
+    //! Random stream for (#seed_, #year_, phase, location, index)
+    URBG engine(Phase phase, uint_fast32_t location, size_t index=0u) const;
+
     //! give birth to children
     void reproduce();
 
@@ -53,36 +212,109 @@ class Population {
     //! evaluate survival
     void survive();
 
+    //! draw the number of deaths in each age class and mark them
+    std::vector<uint8_t> draw_deaths_by_cohort(uint_fast32_t location) const;
+
+    //! release and remove marked individuals
+    void remove_dead(uint_fast32_t location, const std::vector<uint8_t>& is_dead);
+
     //! evaluate migration
     void migrate();
 
+    //! draw destinations of each (location, age) from a multinomial and scatter them
+    std::vector<uint_fast32_t> draw_destinations_by_cohort(
+      const std::vector<int32_t>& birth_year, uint_fast32_t location, Phase phase) const;
+
+    //! @name Phases of PopulationParams::COUNT_ONLY
+    /*! The same probabilities as the individual-based ones are applied to
+        #age_counts_ and #male_counts_ with a draw per (location, age, sex).
+    */
+    //@{
+    void reproduce_counts();
+    void survive_counts();
+    void migrate_counts();
+    //@}
+
     //! sample individuals
-    void sample(std::vector<std::vector<std::shared_ptr<Individual>>>* subpops,
-                const std::vector<size_t>& sample_sizes);
+    /*! @param selectivity PopulationParams::SAMPLE_SELECTIVITY or empty
+    */
+    void sample(std::vector<Subpopulation>* subpops,
+                const std::vector<size_t>& sample_sizes, Phase phase,
+                const std::vector<double>& selectivity={});
+    //! sample juveniles from #juvenile_families_, creating only the sampled ones
+    /*! The same draws as sample() pick the same juveniles
+        as if they were stored in a Subpopulation in the order of birth.
+    */
+    void sample_juveniles(const std::vector<size_t>& sample_sizes);
+    //! create the juvenile at `position` of a record with a father drawn for the position
+    handle_type create_juvenile(uint_fast32_t location, size_t record, uint64_t position, bool is_male);
+    //! take over the juvenile at `position` of a record, creating it unless created at birth
+    handle_type take_juvenile(uint_fast32_t location, size_t record, uint64_t position, bool is_male);
+    //! release the references held by #juvenile_families_ of a location and clear it
+    void release_families(uint_fast32_t location);
 
     //! append current state to #demography_
     void append_demography(int_fast32_t season);
 
-    //! Count individuals for each location and age
-    std::vector<std::vector<uint_fast32_t>> count(int_fast32_t season) const;
+    //! Count pairs of sampled individuals: parent-offspring, half-sibling, full-sibling
+    std::vector<uint_fast64_t> count_kin_pairs() const;
+
+    //! shift #age_counts_ by one year
+    void increment_age();
+
+    //! @name Update #age_counts_ for a change in a subpopulation
+    //@{
+    void count_in(uint_fast32_t location, int_fast32_t birth_year) noexcept {
+        ++age_counts_[location][year_ - birth_year];
+    }
+    void count_out(uint_fast32_t location, int_fast32_t birth_year) noexcept {
+        --age_counts_[location][year_ - birth_year];
+    }
+    //@}
 
     //! Return size of #subpopulations_
     size_t num_subpops() const noexcept {return subpopulations_.size();}
 
-    //! Individual array for each subpopulation
-    std::vector<std::vector<std::shared_ptr<Individual>>> subpopulations_;
-    //! first-year individuals
-    std::vector<std::vector<std::shared_ptr<Individual>>> juveniles_subpops_;
+    //! enforce PopulationParams::MAX_MEMORY before allocating `extra` bytes
+    /*! Pedigree is compacted when the budget is nearly used up,
+        and std::runtime_error is thrown if it is not enough.
+    */
+    void check_memory(size_t extra=0u);
+    //! Pedigree::compact() and update handles
+    void compact_pedigree();
+
+    //! Individual columns for each subpopulation
+    std::vector<Subpopulation> subpopulations_;
+    //! first-year individuals until sample_juveniles() or migrate()
+    std::vector<Families> juvenile_families_;
+    //! Individuals in #subpopulations_; [[count for each age] for each location]
+    std::vector<std::vector<Demography::count_type>> age_counts_;
     //! Counts of juveniles; [[number for each location] for each season]
     std::vector<std::vector<uint_fast32_t>> juveniles_demography_;
+    //! Males in #age_counts_ if PopulationParams::COUNT_ONLY
+    std::vector<std::vector<Demography::count_type>> male_counts_;
+    //! Males in the last season of #juveniles_demography_ if PopulationParams::COUNT_ONLY
+    std::vector<uint_fast32_t> juvenile_males_;
     //! samples: capture_year => individuals
-    std::vector<std::map<int_fast32_t, std::vector<std::shared_ptr<Individual>>>> loc_year_samples_;
-    //! (year, season) => [[count for each age] for each location]
-    std::map<std::pair<int_fast32_t, int_fast32_t>, std::vector<std::vector<uint_fast32_t>>> demography_;
+    std::vector<std::map<int_fast32_t, std::vector<handle_type>>> loc_year_samples_;
+    //! census at the end of reproduction (season 0) and of each year (season 3)
+    Demography demography_;
+    //! receiver of censuses instead of #demography_ if set
+    demography_sink_type demography_sink_ = nullptr;
+    //! receiver of the time spent in each phase if set
+    Profile* profile_ = nullptr;
+    //! Parameters and tables shared with other instances
+    const std::shared_ptr<const Context> context_;
+    //! Parameters
+    const param_type params_;
+    //! storage of all the living and ancestral individuals
+    std::unique_ptr<Pedigree> pedigree_;
+    //! Individuals born before this year are recorded without parents
+    int_fast32_t pedigree_start_ = std::numeric_limits<int_fast32_t>::min();
     //! year
     int_fast32_t year_ = 0;
-    //! random bit generator
-    std::unique_ptr<URBG> engine_;
+    //! key of random streams
+    uint64_t seed_;
 };
 
 } // namespace pbf
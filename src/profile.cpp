@@ -0,0 +1,94 @@
+/*! @file profile.cpp
+    @brief Implementation of Profile class
+*/
+#include "profile.hpp"
+
+#include <clippson/json.hpp>
+
+#include <ostream>
+
+#ifndef _WIN32
+  #include <sys/resource.h>
+#endif
+
+namespace pbf {
+
+constexpr size_t Profile::num_phases;
+constexpr size_t Profile::num_events;
+
+const char* Profile::name(const Phase phase) noexcept {
+    switch (phase) {
+      case Phase::reproduce: return "reproduce";
+      case Phase::survive:   return "survive";
+      case Phase::sample:    return "sample";
+      case Phase::migrate:   return "migrate";
+      case Phase::census:    return "census";
+      case Phase::output:    return "output";
+    }
+    return "";
+}
+
+const char* Profile::name(const Event event) noexcept {
+    switch (event) {
+      case Event::born:     return "born";
+      case Event::died:     return "died";
+      case Event::migrated: return "migrated";
+    }
+    return "";
+}
+
+uint64_t Profile::total(const Event event) const noexcept {
+    uint64_t n = 0u;
+    for (const auto& record: years_) n += record.events[index(event)];
+    return n;
+}
+
+uint64_t Profile::peak_rss() noexcept {
+#ifdef _WIN32
+    return 0u;
+#else
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) return 0u;
+  #ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+  #else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024u;
+  #endif
+#endif
+}
+
+std::ostream& Profile::write_json(std::ostream& ost) const {
+    auto to_seconds = [](clock_type::duration x) {
+        return std::chrono::duration<double>(x).count();
+    };
+    nlohmann::json obj;
+    obj["peak_rss"] = peak_rss();
+    auto& seconds = obj["seconds"];
+    for (size_t i=0u; i<num_phases; ++i) {
+        seconds[name(static_cast<Phase>(i))] = to_seconds(elapsed_[i]);
+    }
+    auto& events = obj["events"];
+    for (size_t i=0u; i<num_events; ++i) {
+        const auto event = static_cast<Event>(i);
+        events[name(event)] = total(event);
+    }
+    auto& years = obj["years"];
+    years = nlohmann::json::array();
+    for (const auto& record: years_) {
+        nlohmann::json row;
+        row["year"] = record.year;
+        for (size_t i=0u; i<num_phases; ++i) {
+            const auto phase = static_cast<Phase>(i);
+            if (phase == Phase::output) continue;
+            row["seconds"][name(phase)] = to_seconds(record.elapsed[i]);
+        }
+        for (size_t i=0u; i<num_events; ++i) {
+            row[name(static_cast<Event>(i))] = record.events[i];
+        }
+        row["pedigree_size"] = record.pedigree_size;
+        years.push_back(std::move(row));
+    }
+    return ost << obj.dump(2) << "\n";
+}
+
+} // namespace pbf
@@ -0,0 +1,162 @@
+/*! @file profile.hpp
+    @brief Interface of Profile class
+*/
+#pragma once
+#ifndef PBT_PROFILE_HPP_
+#define PBT_PROFILE_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Accumulator of wall time spent in each phase of Population::run()
+
+    Population times its phases only while a Profile is attached
+    by Population::set_profile(), so that it costs nothing otherwise.
+    Wall time and events are also recorded for each year between
+    begin_year() and end_year().
+    An optional probe, e.g., a counter of allocations,
+    is read at both ends of each phase and its increase is accumulated.
+
+    Program attaches a Profile only to the first replicate,
+    whereas peak_rss() is measured for the whole process;
+    it includes the other replicates running at the same time
+    and anything allocated before the run, e.g., a restored checkpoint.
+*/
+class Profile {
+  public:
+    //! Stages timed separately
+    enum class Phase: uint32_t {
+        reproduce,
+        survive,
+        sample,
+        migrate,
+        census,
+        output,
+    };
+    //! Number of Phase values
+    static constexpr size_t num_phases = 6u;
+    //! Events counted in each year
+    enum class Event: uint32_t {
+        born,
+        died,
+        migrated,
+    };
+    //! Number of Event values
+    static constexpr size_t num_events = 3u;
+    //! Counter read at both ends of each phase
+    using probe_type = std::function<uint64_t()>;
+    //! Alias
+    using clock_type = std::chrono::steady_clock;
+
+    //! Measure a phase from construction to destruction; no-op if profile is nullptr
+    class Scope {
+      public:
+        //! start
+        Scope(Profile* profile, Phase phase)
+        : profile_(profile), phase_(phase) {
+            if (profile_) {
+                probed_ = profile_->probe();
+                start_ = clock_type::now();
+            }
+        }
+        //! stop and add to the profile
+        ~Scope() {
+            if (profile_) profile_->add(phase_, clock_type::now() - start_, profile_->probe() - probed_);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+      private:
+        Profile* profile_;
+        Phase phase_;
+        clock_type::time_point start_;
+        uint64_t probed_ = 0u;
+    };
+
+    //! constructor
+    explicit Profile(probe_type probe=nullptr): probe_(std::move(probe)) {}
+
+    //! total wall time of a phase in seconds
+    double seconds(Phase phase) const noexcept {
+        return std::chrono::duration<double>(elapsed_[index(phase)]).count();
+    }
+    //! total increase of the probe during a phase
+    uint64_t probed(Phase phase) const noexcept {return probed_[index(phase)];}
+    //! name of a phase
+    static const char* name(Phase phase) noexcept;
+    //! name of an event
+    static const char* name(Event event) noexcept;
+    //! reset all the accumulators to zero
+    void clear() noexcept {
+        elapsed_.fill(clock_type::duration::zero());
+        probed_.fill(0u);
+        years_.clear();
+        in_year_ = false;
+    }
+
+    //! start a per-year record
+    void begin_year(int32_t year) {
+        years_.push_back(Year{year, {}, {}, 0u});
+        in_year_ = true;
+    }
+    //! close the per-year record with the number of pedigree records
+    void end_year(size_t pedigree_size) noexcept {
+        years_.back().pedigree_size = pedigree_size;
+        in_year_ = false;
+    }
+    //! add `n` events to the current year
+    void count(Event event, uint64_t n) noexcept {
+        if (in_year_) years_.back().events[index(event)] += n;
+    }
+    //! total number of events
+    uint64_t total(Event event) const noexcept;
+
+    //! maximum resident set size of the whole process in bytes; 0 if unknown
+    static uint64_t peak_rss() noexcept;
+    //! write totals and per-year records in JSON
+    std::ostream& write_json(std::ostream&) const;
+
+  private:
+    //! Record of a year
+    struct Year {
+        int32_t year;
+        std::array<clock_type::duration, num_phases> elapsed;
+        std::array<uint64_t, num_events> events;
+        uint64_t pedigree_size;
+    };
+
+    //! Array index of a phase
+    static size_t index(Phase phase) noexcept {return static_cast<size_t>(phase);}
+    //! Array index of an event
+    static size_t index(Event event) noexcept {return static_cast<size_t>(event);}
+    //! current value of the probe; 0 if not set
+    uint64_t probe() const {return probe_ ? probe_() : 0u;}
+    //! accumulate a measurement
+    void add(Phase phase, clock_type::duration elapsed, uint64_t probed) noexcept {
+        elapsed_[index(phase)] += elapsed;
+        probed_[index(phase)] += probed;
+        if (in_year_) years_.back().elapsed[index(phase)] += elapsed;
+    }
+
+    //! counter read at both ends of each phase
+    probe_type probe_;
+    //! total wall time for each phase
+    std::array<clock_type::duration, num_phases> elapsed_{};
+    //! total increase of the probe for each phase
+    std::array<uint64_t, num_phases> probed_{};
+    //! per-year records
+    std::vector<Year> years_;
+    //! true between begin_year() and end_year()
+    bool in_year_ = false;
+};
+
+} // namespace pbf
+
+#endif /* PBT_PROFILE_HPP_ */
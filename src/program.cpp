@@ -4,8 +4,10 @@
 */
 #include "program.hpp"
 #include "population.hpp"
-#include "individual.hpp"
+#include "context.hpp"
+#include "parallel.hpp"
 #include "config.hpp"
+#include "profile.hpp"
 
 #include <wtl/exception.hpp>
 #include <wtl/debug.hpp>
@@ -13,10 +15,12 @@
 #include <wtl/chrono.hpp>
 #include <clippson/clippson.hpp>
 
-namespace pbf {
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <mutex>
 
-//! Global variables mapper of commane-line arguments
-nlohmann::json VM;
+namespace pbf {
 
 //! Options description for general purpose
 inline clipp::group general_options(nlohmann::json* vm) {
@@ -31,28 +35,48 @@ inline clipp::group general_options(nlohmann::json* vm) {
 //! Program options
 /*! @ingroup params
 
-    Command line option           | Symbol
-    ----------------------------- | -------
-    `-O,--origin`                 | -
-    `-y,--years`                  | -
-    `-l,--last`                   | -
-    `--sa,--sample_size_adult`    | -
-    `--sj,--sample_size_juvenile` | -
-    `-i,--infile`                 | -
-    `-o,--outdir`                 | -
+    Command line option           | Variable
+    ----------------------------- | -------------------------------
+    `-O,--origin`                 | ProgramParams::ORIGIN
+    `-y,--years`                  | ProgramParams::YEARS
+    `-l,--last`                   | ProgramParams::LAST
+    `--sa,--sample_size_adult`    | ProgramParams::SAMPLE_SIZE_ADULT
+    `--sj,--sample_size_juvenile` | ProgramParams::SAMPLE_SIZE_JUVENILE
+    `--pedigree_depth`            | ProgramParams::PEDIGREE_DEPTH
+    `-i,--infile`                 | ProgramParams::INFILE
+    `-o,--outdir`                 | ProgramParams::OUTDIR
+    `--seed`                      | ProgramParams::SEED
+    `--replicates`                | ProgramParams::REPLICATES
+    `--sweep`                     | ProgramParams::SWEEP
+    `--summary`                   | ProgramParams::SUMMARY
+    `--binary`                    | ProgramParams::BINARY
+    `--checkpoint`                | ProgramParams::CHECKPOINT
+    `--checkpoint_year`           | ProgramParams::CHECKPOINT_YEAR
+    `--restore`                   | ProgramParams::RESTORE
+    `--profile`                   | ProgramParams::PROFILE
 */
-inline clipp::group program_options(nlohmann::json* vm) {
-    const std::string OUT_DIR = wtl::strftime("thunnus_%Y%m%d_%H%M%S");
-    const int seed = static_cast<int>(std::random_device{}()); // 32-bit signed integer for R
+inline clipp::group program_options(nlohmann::json* vm, ProgramParams* p) {
+    p->OUTDIR = wtl::strftime("thunnus_%Y%m%d_%H%M%S");
+    p->SEED = static_cast<int>(std::random_device{}()); // 32-bit signed integer for R
     return (
-      wtl::option(vm, {"O", "origin"}, 0.2, "Initial population size relative to K"),
-      wtl::option(vm, {"y", "years"}, 100, "Duration of simulation"),
-      wtl::option(vm, {"l", "last"}, 3, "Sample last _ years"),
-      wtl::option(vm, {"sa", "sample_size_adult"}, std::vector<size_t>{10u, 10u}, "per location"),
-      wtl::option(vm, {"sj", "sample_size_juvenile"}, std::vector<size_t>{10u, 10u}, "per location"),
-      wtl::option(vm, {"i", "infile"}, std::string(""), "config file in json format"),
-      wtl::option(vm, {"o", "outdir"}, OUT_DIR),
-      wtl::option(vm, {"seed"}, seed)
+      wtl::option(vm, {"O", "origin"}, &p->ORIGIN, "Initial population size relative to K"),
+      wtl::option(vm, {"y", "years"}, &p->YEARS, "Duration of simulation"),
+      wtl::option(vm, {"l", "last"}, &p->LAST, "Sample last _ years"),
+      wtl::option(vm, {"sa", "sample_size_adult"}, &p->SAMPLE_SIZE_ADULT, "per location"),
+      wtl::option(vm, {"sj", "sample_size_juvenile"}, &p->SAMPLE_SIZE_JUVENILE, "per location"),
+      wtl::option(vm, {"pedigree_depth"}, &p->PEDIGREE_DEPTH, "Record parents only _ years before sampling (<0: all)"),
+      wtl::option(vm, {"i", "infile"}, &p->INFILE, "config file in json format"),
+      wtl::option(vm, {"o", "outdir"}, &p->OUTDIR),
+      wtl::option(vm, {"seed"}, &p->SEED),
+      wtl::option(vm, {"replicates"}, &p->REPLICATES, "Number of independent runs"),
+      wtl::option(vm, {"sweep"}, &p->SWEEP, "TSV file of parameter sets to summarize"),
+      wtl::option(vm, {"summary"}, &p->SUMMARY, "Statistics written in sweep mode"),
+      wtl::option(vm, {"binary"}, &p->BINARY, "Write binary files in addition to TSV"),
+      wtl::option(vm, {"checkpoint"}, &p->CHECKPOINT, "Binary file to write the state at checkpoint_year"),
+      wtl::option(vm, {"checkpoint_year"}, &p->CHECKPOINT_YEAR, "Negative value means years - last"),
+      wtl::option(vm, {"restore"}, &p->RESTORE, "Binary file of checkpoint to start from; -O, -i, -r, -K, -k, --sweep are not allowed; "
+        "demography is written only after the checkpoint unless --binary is given to both runs"),
+      wtl::option(vm, {"profile"}, &p->PROFILE, "Write time and counts of each phase to profile.json in outdir")
     ).doc("Program:");
 }
 
@@ -75,19 +99,76 @@ inline clipp::group individual_options(nlohmann::json* vm, IndividualParams* p)
     ).doc("Individual:");
 }
 
+//! Population options
+/*! @ingroup params
+
+    Command line option      | Variable
+    ------------------------ | -------------------------------
+    `--cohort_survival`      | PopulationParams::COHORT_SURVIVAL
+    `--cohort_migration`     | PopulationParams::COHORT_MIGRATION
+    `--cohort_recruitment`   | PopulationParams::COHORT_RECRUITMENT
+    `-j,--threads`           | PopulationParams::NUM_THREADS
+    `--sample_selectivity`   | PopulationParams::SAMPLE_SELECTIVITY
+    `--max_memory`           | PopulationParams::MAX_MEMORY
+    `--count_only`           | PopulationParams::COUNT_ONLY
+    `--eager_juveniles`      | PopulationParams::EAGER_JUVENILES
+*/
+inline clipp::group population_options(nlohmann::json* vm, PopulationParams* p) {
+    return (
+      wtl::option(vm, {"cohort_survival"}, &p->COHORT_SURVIVAL,
+        "Draw the number of deaths per age class instead of per individual"
+      ),
+      wtl::option(vm, {"cohort_migration"}, &p->COHORT_MIGRATION,
+        "Draw the number of migrants per age class instead of per individual"
+      ),
+      wtl::option(vm, {"cohort_recruitment"}, &p->COHORT_RECRUITMENT,
+        "Draw the number of juveniles per age class of mothers instead of per mother"
+      ),
+      wtl::option(vm, {"j", "threads"}, &p->NUM_THREADS,
+        "Number of threads; results are identical for any value"
+      ),
+      wtl::option(vm, {"sample_selectivity"}, &p->SAMPLE_SELECTIVITY,
+        "Relative probability of adults being sampled for each age"
+      ),
+      wtl::option(vm, {"max_memory"}, &p->MAX_MEMORY,
+        "Memory budget of a replicate in MiB; pedigree is compacted or the run fails fast"
+      ),
+      wtl::option(vm, {"count_only"}, &p->COUNT_ONLY,
+        "Track only counts of (location, age, sex) without pedigree; needs --sa 0 --sj 0"
+      ),
+      wtl::option(vm, {"eager_juveniles"}, &p->EAGER_JUVENILES,
+        "Create each juvenile at birth instead of family records; results are identical"
+      )
+    ).doc("Population:");
+}
+
+//! true if any of `names` is given as an option in `arguments`
+inline bool is_given(const std::vector<std::string>& arguments, const std::vector<std::string>& names) {
+    for (const auto& arg: arguments) {
+        const auto pos = arg.find_first_not_of('-');
+        if (pos == 0u || pos == std::string::npos) continue;
+        const auto name = arg.substr(pos, arg.find('=') - pos);
+        if (std::find(names.begin(), names.end(), name) != names.end()) return true;
+    }
+    return false;
+}
+
 Program::Program(const std::vector<std::string>& arguments)
-: command_args_(arguments) {
+: command_args_(arguments),
+  population_params_(std::make_unique<PopulationParams>()) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(0);
     std::cout.precision(15);
     std::cerr.precision(6);
 
     nlohmann::json vm_local;
+    nlohmann::json vm;
     IndividualParams individual_params;
     auto cli = (
       general_options(&vm_local),
-      program_options(&VM),
-      individual_options(&VM, &individual_params)
+      program_options(&vm, &params_),
+      individual_options(&vm, &individual_params),
+      population_options(&vm, population_params_.get())
     );
     wtl::parse(cli, arguments);
     if (vm_local.at("help")) {
@@ -100,39 +181,226 @@ Program::Program(const std::vector<std::string>& arguments)
         std::cout << PROJECT_VERSION << "\n";
         throw wtl::ExitSuccess();
     }
-    Individual::param(individual_params);
     if (vm_local.at("default")) {
-        Individual::write_json(std::cout);
+        Context{}.write_json(std::cout);
         throw wtl::ExitSuccess();
     }
-    const std::string infile = VM.at("infile");
-    if (!infile.empty()) {
-        auto ifs = wtl::make_ifs(infile);
-        Individual::read_json(ifs);
+    if (!params_.RESTORE.empty()) {
+        if (!params_.SWEEP.empty()) {
+            throw std::runtime_error("--restore cannot be used with --sweep");
+        }
+        // the initial state and Context are taken from the checkpoint
+        const std::vector<std::vector<std::string>> ignored = {
+          {"O", "origin"}, {"i", "infile"},
+          {"r", "recruitment"}, {"K", "carrying_capacity"}, {"k", "overdispersion"}
+        };
+        for (const auto& names: ignored) {
+            if (is_given(arguments, names)) {
+                throw std::runtime_error("--" + names.back() + " cannot be used with --restore");
+            }
+        }
+    }
+    if (params_.INFILE.empty()) {
+        context_ = std::make_shared<const Context>(individual_params);
+    } else {
+        auto ifs = wtl::make_ifs(params_.INFILE);
+        context_ = std::make_shared<const Context>(individual_params, ifs);
+    }
+    if (!params_.RESTORE.empty()) {
+        std::ifstream ifs(params_.RESTORE, std::ios::binary);
+        if (!ifs) throw std::runtime_error("cannot open " + params_.RESTORE);
+        restored_ = std::make_unique<Population>(ifs, static_cast<uint32_t>(params_.SEED), *population_params_);
+    }
+    if (params_.PROFILE) {
+        if (params_.OUTDIR.empty() || !params_.SWEEP.empty()) {
+            throw std::runtime_error("--profile needs --outdir and cannot be used with --sweep");
+        }
+        profile_ = std::make_unique<Profile>();
+    }
+    if (params_.CHECKPOINT_YEAR < 0) {
+        params_.CHECKPOINT_YEAR = params_.YEARS - params_.LAST;
+    }
+    if (!params_.CHECKPOINT.empty()) {
+        const auto start = restored_ ? restored_->year() : 0;
+        if (params_.CHECKPOINT_YEAR <= start || params_.CHECKPOINT_YEAR > params_.YEARS) {
+            std::ostringstream oss;
+            oss << "--checkpoint_year " << params_.CHECKPOINT_YEAR
+                << " is out of the simulated years (" << start << ", " << params_.YEARS << "]";
+            throw std::runtime_error(oss.str());
+        }
     }
-    config_ = VM.dump(2) + "\n";
+    const auto available = Population::summary_names();
+    for (const auto& stat: params_.SUMMARY) {
+        if (std::find(available.begin(), available.end(), stat) == available.end()) {
+            throw std::runtime_error("unknown summary statistic: " + stat);
+        }
+    }
+    config_ = vm.dump(2) + "\n";
     if (vm_local.at("verbose")) {
         std::cerr << wtl::iso8601datetime() << std::endl;
         std::cerr << config_ << std::endl;
-        Individual::write_json(std::cerr);
+        context_->write_json(std::cerr);
     }
 }
 
 Program::~Program() = default;
 
-void Program::run() {
-    const double K = VM.at("carrying_capacity");
-    const double O = VM.at("origin");
-    population_ = std::make_unique<Population>(
-        static_cast<size_t>(K * O),
-        VM.at("seed")
-    );
-    population_->run(
-        VM.at("years"),
-        VM.at("sample_size_adult"),
-        VM.at("sample_size_juvenile"),
-        VM.at("last")
+void Program::run(const callback_type& callback, const sink_factory_type& make_sink) {
+    const size_t replicates = std::max(num_replicates(), size_t{1u});
+    PopulationParams population_params = *population_params_;
+    unsigned num_threads = 1u;
+    if (replicates > 1u) {
+        std::swap(num_threads, population_params.NUM_THREADS);
+    }
+    const auto seed = static_cast<uint32_t>(params_.SEED);
+    // fork() freezes the pedigree of the restored state on the first call
+    std::mutex restore_mutex;
+    parallel_for(num_threads, replicates, [&, this](const size_t i) {
+        // replicate 0 uses the plain seed; others use the upper 32 bits of the key
+        const uint64_t key = (static_cast<uint64_t>(i) << 32) | seed;
+        std::unique_ptr<Population> population;
+        if (!restored_) {
+            const double K = context_->param().CARRYING_CAPACITY;
+            population = std::make_unique<Population>(
+              static_cast<size_t>(K * params_.ORIGIN), key, context_, population_params);
+        } else {
+            std::lock_guard<std::mutex> lock(restore_mutex);
+            population = restored_->fork(key, nullptr, population_params);
+        }
+        if (i == 0u && profile_) population->set_profile(profile_.get());
+        std::function<void(const Population&)> on_year_end = nullptr;
+        if (i == 0u && !params_.CHECKPOINT.empty()) {
+            on_year_end = [this](const Population& x) {
+                if (x.year() != params_.CHECKPOINT_YEAR) return;
+                std::ofstream ofs(params_.CHECKPOINT, std::ios::binary);
+                x.write_checkpoint(ofs);
+            };
+        }
+        simulate(population.get(), make_sink ? make_sink(i) : nullptr, on_year_end);
+        if (callback) callback(*population, i);
+        population->set_profile(nullptr);
+        if (i == 0u) population_ = std::move(population);
+    });
+}
+
+void Program::simulate(Population* population, demography_sink_type sink,
+                       const std::function<void(const Population&)>& on_year_end) const {
+    population->set_demography_sink(std::move(sink));
+    population->run(
+        params_.YEARS,
+        params_.SAMPLE_SIZE_ADULT,
+        params_.SAMPLE_SIZE_JUVENILE,
+        params_.LAST,
+        params_.PEDIGREE_DEPTH,
+        on_year_end
     );
+    population->set_demography_sink(nullptr);
+}
+
+//! Parameter set for Program::sweep()
+struct SweepRow {
+    std::shared_ptr<const Context> context;
+    double origin;
+    uint32_t seed;
+};
+
+//! Split a line of TSV
+inline std::vector<std::string> split_tsv(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, '\t')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+void Program::sweep(std::ostream& ost) const {
+    auto ifs = wtl::make_ifs(params_.SWEEP);
+    std::string line;
+    std::getline(ifs, line);
+    const auto header = split_tsv(line);
+    const auto json_keys = IndividualJson::names();
+    nlohmann::json base_json;
+    {
+        std::stringstream buffer;
+        context_->write_json(buffer);
+        buffer >> base_json;
+    }
+    std::vector<SweepRow> rows;
+    while (std::getline(ifs, line)) {
+        if (line.empty()) continue;
+        const auto fields = split_tsv(line);
+        if (fields.size() != header.size()) {
+            throw std::runtime_error("wrong number of columns in " + params_.SWEEP + ": " + line);
+        }
+        IndividualParams individual_params = context_->param();
+        SweepRow row{nullptr, params_.ORIGIN, static_cast<uint32_t>(params_.SEED) + static_cast<uint32_t>(rows.size())};
+        nlohmann::json json = base_json;
+        for (size_t j=0; j<header.size(); ++j) {
+            const auto& key = header[j];
+            const auto& value = fields[j];
+            if (key == "recruitment") {
+                individual_params.RECRUITMENT_COEF = std::stod(value);
+            } else if (key == "carrying_capacity") {
+                individual_params.CARRYING_CAPACITY = std::stod(value);
+            } else if (key == "overdispersion") {
+                individual_params.NEGATIVE_BINOM_K = std::stod(value);
+            } else if (key == "origin") {
+                row.origin = std::stod(value);
+            } else if (key == "seed") {
+                row.seed = static_cast<uint32_t>(std::stol(value));
+            } else if (key == "infile") {
+                auto json_ifs = wtl::make_ifs(value);
+                nlohmann::json obj;
+                json_ifs >> obj;
+                json.update(obj);
+            } else if (std::find(json_keys.begin(), json_keys.end(), key) != json_keys.end()) {
+                json[key] = nlohmann::json::parse(value);
+            } else {
+                throw std::runtime_error("unknown column in " + params_.SWEEP + ": " + key);
+            }
+        }
+        std::istringstream iss(json.dump());
+        row.context = std::make_shared<const Context>(individual_params, iss);
+        rows.push_back(std::move(row));
+    }
+
+    const size_t replicates = std::max(num_replicates(), size_t{1u});
+    const size_t num_tasks = rows.size() * replicates;
+    PopulationParams population_params = *population_params_;
+    unsigned num_threads = 1u;
+    std::swap(num_threads, population_params.NUM_THREADS);
+    std::vector<std::string> results(num_tasks);
+    std::vector<uint8_t> is_done(num_tasks, 0u);
+    size_t num_written = 0u;
+    std::mutex mtx;
+    ost << "set\treplicate\tstatistic\tyear\tvalue\n";
+    parallel_for(num_threads, num_tasks, [&, this](const size_t task) {
+        const size_t i = task / replicates;
+        const size_t rep = task % replicates;
+        const SweepRow& row = rows[i];
+        const uint64_t key = (static_cast<uint64_t>(rep) << 32) | row.seed;
+        const double K = row.context->param().CARRYING_CAPACITY;
+        auto population = std::make_unique<Population>(
+          static_cast<size_t>(K * row.origin), key, row.context, population_params);
+        simulate(population.get());
+        std::ostringstream oss;
+        oss.precision(ost.precision());
+        population->write_summary(oss, params_.SUMMARY,
+          std::to_string(i) + "\t" + std::to_string(rep) + "\t");
+        population.reset();
+        std::lock_guard<std::mutex> lock(mtx);
+        results[task] = oss.str();
+        is_done[task] = 1u;
+        while (num_written < num_tasks && is_done[num_written]) {
+            ost << results[num_written];
+            results[num_written].clear();
+            results[num_written].shrink_to_fit();
+            ++num_written;
+        }
+        ost.flush();
+    });
 }
 
 std::string Program::sample_family() const {
@@ -147,10 +415,6 @@ std::string Program::demography() const {
     return oss.str();
 }
 
-std::string Program::outdir() const {
-    return VM.at("outdir");
-}
-
 //! std::cout.rdbuf
 std::streambuf* std_cout_rdbuf(std::streambuf* buf) {
     return std::cout.rdbuf(buf);
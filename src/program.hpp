@@ -8,21 +8,105 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <functional>
 
 namespace pbf {
 
 class Population;
+struct PopulationParams;
+class Context;
+class Demography;
+class Profile;
+
+//! @brief Parameters for Program class (command-line)
+/*! @ingroup params
+*/
+struct ProgramParams {
+    //! @ingroup params
+    //@{
+    //! Initial population size relative to K
+    double ORIGIN = 0.2;
+    //! Duration of simulation
+    int YEARS = 100;
+    //! Sample last _ years
+    int LAST = 3;
+    //! per location
+    std::vector<size_t> SAMPLE_SIZE_ADULT = {10u, 10u};
+    //! per location
+    std::vector<size_t> SAMPLE_SIZE_JUVENILE = {10u, 10u};
+    //! Record parents only _ years before sampling
+    int PEDIGREE_DEPTH = -1;
+    //! config file in json format
+    std::string INFILE = "";
+    //! output directory
+    std::string OUTDIR = "";
+    //! seed of random streams; 32-bit signed integer for R
+    int SEED = 0;
+    //! Number of independent runs with different random streams
+    int REPLICATES = 1;
+    //! TSV file of parameter sets for Program::sweep()
+    std::string SWEEP = "";
+    //! Write binary files in addition to TSV
+    bool BINARY = false;
+    //! Binary file to write the state of the first replicate
+    std::string CHECKPOINT = "";
+    //! Year to write ProgramParams::CHECKPOINT; negative value means YEARS - LAST
+    //! It must be after the restored year if any and not after YEARS.
+    int CHECKPOINT_YEAR = -1;
+    //! Binary file to restore the initial state and Context from
+    /*! ORIGIN, INFILE and IndividualParams would be ignored,
+        so that they are rejected if given together, as well as SWEEP.
+        The state is read once and each replicate is a Population::fork() of it.
+        Censuses streamed before the checkpoint are not in it,
+        so that demography is written only for the following years
+        unless BINARY is given to both runs.
+    */
+    std::string RESTORE = "";
+    //! Time and count each phase of the first replicate into OUTDIR/profile.json
+    /*! It is rejected without OUTDIR or with SWEEP, which write no profile.
+    */
+    bool PROFILE = false;
+    //! Statistics written by Program::sweep()
+    std::vector<std::string> SUMMARY = {"biomass", "age_mean", "age_var", "po_pairs", "hs_pairs", "fs_pairs"};
+    //@}
+};
 
 /*! @brief Program class
 */
 class Program {
   public:
+    //! Called for each finished replicate with its index
+    using callback_type = std::function<void(const Population&, size_t)>;
+    //! Alias of Population::demography_sink_type
+    using demography_sink_type = std::function<void(const Demography&)>;
+    //! Called before each replicate with its index to get its demography sink
+    using sink_factory_type = std::function<demography_sink_type(size_t)>;
     //! parse command arguments
     Program(const std::vector<std::string>& args);
     //! destructor
     ~Program();
     //! top level function that should be called once from global main
-    void run();
+    /*! Replicates are run on PopulationParams::NUM_THREADS threads,
+        and passed to `callback` from the thread that ran it.
+        Only the first replicate is kept for population().
+        If `make_sink` is given, censuses are streamed to its result
+        as in Population::set_demography_sink(),
+        and the sink is destroyed as soon as the replicate finishes.
+        The first replicate is timed into profile() including `callback`
+        if it uses Profile::Phase::output.
+    */
+    void run(const callback_type& callback=nullptr, const sink_factory_type& make_sink=nullptr);
+    //! run each parameter set in ProgramParams::SWEEP and write summary statistics
+    /*! The first line of the file names the columns, which are
+        any of `recruitment`, `carrying_capacity`, `overdispersion`, `origin`, `seed`,
+        `infile`, and the keys of JSON parameters with JSON values.
+        Unspecified parameters are taken from the command line,
+        and `seed` defaults to ProgramParams::SEED plus the row index.
+        Each set is run ProgramParams::REPLICATES times on
+        PopulationParams::NUM_THREADS threads,
+        and rows are written in order as soon as the preceding ones are done.
+    */
+    void sweep(std::ostream& ost) const;
 
     //! @name Getter for main()
     //@{
@@ -30,8 +114,16 @@ class Program {
     const Population& population() const noexcept {return *population_;}
     //! Get #config_
     const std::string& config() const noexcept {return config_;}
-    //! Get VM["outdir"]
-    std::string outdir() const;
+    //! Get ProgramParams::OUTDIR
+    std::string outdir() const {return params_.OUTDIR;}
+    //! Get ProgramParams::REPLICATES
+    size_t num_replicates() const noexcept {return static_cast<size_t>(params_.REPLICATES);}
+    //! Get ProgramParams::BINARY
+    bool writes_binary() const noexcept {return params_.BINARY;}
+    //! Get #profile_; nullptr unless ProgramParams::PROFILE
+    Profile* profile() const noexcept {return profile_.get();}
+    //! true if ProgramParams::SWEEP is given
+    bool is_sweep() const noexcept {return !params_.SWEEP.empty();}
     //@}
 
     //! @name Output for Rcpp
@@ -43,12 +135,26 @@ class Program {
     //@}
 
   private:
+    //! run a Population until ProgramParams::YEARS
+    void simulate(Population* population, demography_sink_type sink=nullptr,
+                  const std::function<void(const Population&)>& on_year_end=nullptr) const;
+
     //! command line arguments
     std::vector<std::string> command_args_;
     //! writen to "config.json"
     std::string config_ = "";
+    //! Parameters of this class
+    ProgramParams params_;
+    //! Parameters for #population_
+    std::unique_ptr<PopulationParams> population_params_;
+    //! Parameters and tables shared by replicates
+    std::shared_ptr<const Context> context_;
+    //! state read from ProgramParams::RESTORE
+    std::unique_ptr<Population> restored_;
     //! Population instance
     std::unique_ptr<Population> population_;
+    //! Time and counts of the first replicate if ProgramParams::PROFILE
+    std::unique_ptr<Profile> profile_;
 };
 
 //! @name Workaround for R/Rcpp
@@ -0,0 +1,77 @@
+/*! @file random.hpp
+    @brief Fast uniform variates from 64-bit engines
+*/
+#pragma once
+#ifndef PBT_RANDOM_HPP_
+#define PBT_RANDOM_HPP_
+
+#include <cstdint>
+#include <limits>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+//! @cond
+namespace detail {
+
+template <class URBG> inline
+void assert_full_64bit() noexcept {
+    static_assert(URBG::min() == 0u && URBG::max() == std::numeric_limits<uint64_t>::max(),
+                  "URBG must generate all 64 bits");
+}
+
+//! upper and lower halves of a 64x64-bit product
+inline uint64_t multiply_high(uint64_t a, uint64_t b, uint64_t* low) noexcept {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128_type;
+    const uint128_type product = static_cast<uint128_type>(a) * b;
+    *low = static_cast<uint64_t>(product);
+    return static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo;
+    const uint64_t hi_lo = a_hi * b_lo;
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + a_lo * b_hi;
+    *low = (cross << 32) | (lo_lo & 0xFFFFFFFFu);
+    return (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi;
+#endif
+}
+
+} // namespace detail
+//! @endcond
+
+/*! @brief Uniform double in [0, 1) from the upper 53 bits of an output
+
+    Unlike `std::generate_canonical`, it never rounds up to 1
+    and costs a shift and a multiplication.
+*/
+template <class URBG> inline
+double canonical(URBG& engine) {
+    detail::assert_full_64bit<URBG>();
+    return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*! @brief Uniform integer in [0, n) for `n > 0` without bias
+
+    Lemire (2019) "Fast random integer generation in an interval".
+    A division is needed only for rejection, which is rare unless `n` is huge.
+*/
+template <class URBG> inline
+uint64_t bounded(URBG& engine, const uint64_t n) {
+    detail::assert_full_64bit<URBG>();
+    uint64_t low;
+    uint64_t high = detail::multiply_high(engine(), n, &low);
+    if (low < n) {
+        const uint64_t threshold = (0u - n) % n;
+        while (low < threshold) {
+            high = detail::multiply_high(engine(), n, &low);
+        }
+    }
+    return high;
+}
+
+} // namespace pbf
+
+#endif /* PBT_RANDOM_HPP_ */
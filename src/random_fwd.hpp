@@ -4,8 +4,17 @@
 
 #include <random>
 
+// The engine is chosen at build time with `cmake -DTEKKA_RNG=xoshiro`
+#if defined(PBF_RNG_XOSHIRO)
+  #include "xoshiro.hpp"
 namespace pbf {
-  using URBG = std::mt19937_64;
+  using URBG = Xoshiro256pp;
 }
+#else
+  #include "philox.hpp"
+namespace pbf {
+  using URBG = Philox;
+}
+#endif
 
 #endif//PBF_RANDOM_FWD_HPP
@@ -0,0 +1,187 @@
+/*! @file subpopulation.hpp
+    @brief Interface of Subpopulation class
+*/
+#pragma once
+#ifndef PBT_SUBPOPULATION_HPP_
+#define PBT_SUBPOPULATION_HPP_
+
+#include "alias_table.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <memory>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Individuals in a location stored as parallel columns
+
+    The columns that are read in every iteration are kept contiguous
+    so that Population can stream through them without touching Pedigree.
+    The order of individuals is not preserved by remove().
+*/
+struct Subpopulation {
+    //! Alias of Pedigree::handle_type
+    using handle_type = uint32_t;
+
+    //! number of individuals
+    size_t size() const noexcept {return handle.size();}
+    //! true if no individual
+    bool empty() const noexcept {return handle.empty();}
+    //! reserve memory for n individuals
+    void reserve(size_t n) {
+        handle.reserve(n);
+        birth_year.reserve(n);
+        is_male.reserve(n);
+    }
+    //! shrink to the first n individuals
+    void resize(size_t n) {
+        handle.resize(n);
+        birth_year.resize(n);
+        is_male.resize(n);
+    }
+    //! remove all
+    void clear() noexcept {
+        handle.clear();
+        birth_year.clear();
+        is_male.clear();
+    }
+    //! append an individual
+    void push_back(handle_type h, int32_t year, bool male) {
+        handle.push_back(h);
+        birth_year.push_back(year);
+        is_male.push_back(male);
+    }
+    //! append i-th individual of other
+    void push_back(const Subpopulation& other, size_t i) {
+        push_back(other.handle[i], other.birth_year[i], other.is_male[i]);
+    }
+    //! append all the individuals of other
+    void append(const Subpopulation& other) {
+        handle.insert(handle.end(), other.handle.begin(), other.handle.end());
+        birth_year.insert(birth_year.end(), other.birth_year.begin(), other.birth_year.end());
+        is_male.insert(is_male.end(), other.is_male.begin(), other.is_male.end());
+    }
+    //! overwrite j-th individual with i-th
+    void move(size_t i, size_t j) noexcept {
+        handle[j] = handle[i];
+        birth_year[j] = birth_year[i];
+        is_male[j] = is_male[i];
+    }
+    //! remove i-th individual by moving the last one to its place
+    void remove(size_t i) noexcept {
+        handle[i] = handle.back();
+        birth_year[i] = birth_year.back();
+        is_male[i] = is_male.back();
+        pop_back();
+    }
+    //! remove the last individual
+    void pop_back() noexcept {
+        handle.pop_back();
+        birth_year.pop_back();
+        is_male.pop_back();
+    }
+    //! swap i-th and j-th individuals
+    void swap(size_t i, size_t j) noexcept {
+        std::swap(handle[i], handle[j]);
+        std::swap(birth_year[i], birth_year[j]);
+        std::swap(is_male[i], is_male[j]);
+    }
+
+    //! bytes allocated for the columns
+    size_t bytes() const noexcept {
+        return handle.capacity() * sizeof(handle_type)
+             + birth_year.capacity() * sizeof(int32_t)
+             + is_male.capacity() * sizeof(uint8_t);
+    }
+
+    //! index in Pedigree
+    std::vector<handle_type> handle;
+    //! year of birth
+    std::vector<int32_t> birth_year;
+    //! sex; not std::vector<bool> to keep it contiguous bytes
+    std::vector<uint8_t> is_male;
+};
+
+/*! @brief Juveniles in a location stored as family records
+
+    Each mother has a record of the numbers of her male and female juveniles
+    born in the year, and the candidate fathers are kept once for all records
+    with the alias table of their fitness.
+    Juveniles are numbered in the order of records, males before females,
+    and the position determines the serial ID and the random stream of the father,
+    so that Population can turn them into Subpopulation entries and Pedigree records
+    only when they are sampled or migrate, in whichever order.
+*/
+struct Families {
+    //! Alias of Pedigree::handle_type
+    using handle_type = uint32_t;
+    //! Alias of Pedigree::id_type
+    using id_type = uint64_t;
+
+    //! number of records
+    size_t size() const noexcept {return mother.size();}
+    //! true if no record
+    bool empty() const noexcept {return mother.empty();}
+    //! number of juveniles born in all the records
+    size_t num_born() const noexcept {
+        size_t n = 0u;
+        for (size_t i=0; i<size(); ++i) n += num_males[i] + num_females[i];
+        return n;
+    }
+    //! number of juveniles not taken yet
+    size_t num_individuals() const noexcept {return num_born() - taken.size();}
+    //! remove all
+    void clear() noexcept {
+        mother.clear();
+        num_males.clear();
+        num_females.clear();
+        males.clear();
+        male_weights.clear();
+        father_table = nullptr;
+        first_id = 0u;
+        taken.clear();
+        handle.clear();
+    }
+    //! append a record
+    void push_back(handle_type m, uint32_t males, uint32_t females) {
+        mother.push_back(m);
+        num_males.push_back(males);
+        num_females.push_back(females);
+    }
+
+    //! bytes allocated for the columns
+    size_t bytes() const noexcept {
+        return (mother.capacity() + males.capacity() + handle.capacity()) * sizeof(handle_type)
+             + (num_males.capacity() + num_females.capacity()) * sizeof(uint32_t)
+             + male_weights.capacity() * sizeof(double)
+             + (father_table ? father_table->size() * (sizeof(double) + sizeof(AliasTable::result_type)) : 0u)
+             + taken.capacity() * sizeof(uint64_t);
+    }
+
+    //! mother of each record
+    std::vector<handle_type> mother;
+    //! number of male juveniles in each record, which come first
+    std::vector<uint32_t> num_males;
+    //! number of female juveniles in each record
+    std::vector<uint32_t> num_females;
+    //! candidate fathers; empty if the pedigree is not recorded
+    std::vector<handle_type> males;
+    //! fitness of #males
+    std::vector<double> male_weights;
+    //! sampler of an index in #males built from #male_weights, shared by branches
+    std::shared_ptr<const AliasTable> father_table;
+    //! serial ID of the juvenile at position 0
+    id_type first_id = 0u;
+    //! positions of the juveniles taken by sampling in ascending order
+    std::vector<uint64_t> taken;
+    //! juveniles created at birth in the order of positions;
+    //! empty unless PopulationParams::EAGER_JUVENILES
+    std::vector<handle_type> handle;
+};
+
+} // namespace pbf
+
+#endif /* PBT_SUBPOPULATION_HPP_ */
@@ -0,0 +1,93 @@
+/*! @file xoshiro.hpp
+    @brief Interface of Xoshiro256pp class
+*/
+#pragma once
+#ifndef PBT_XOSHIRO_HPP_
+#define PBT_XOSHIRO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <limits>
+
+/////////1/////////2/////////3/////////4/////////5/////////6/////////7/////////
+
+namespace pbf {
+
+/*! @brief Random bit generator xoshiro256++
+
+    Blackman and Vigna (2021) "Scrambled linear pseudorandom number generators".
+    It has the same interface as Philox,
+    so that either can be chosen as URBG at build time.
+    A stream is seeded by SplitMix64 from a hash of the seed and the stream words;
+    unlike Philox, streams are independent only with overwhelming probability.
+*/
+class Xoshiro256pp {
+  public:
+    //! Alias
+    using result_type = uint64_t;
+    //! Alias
+    using state_type = std::array<uint64_t, 4u>;
+
+    //! stream 0 of a seed
+    explicit Xoshiro256pp(uint64_t seed=0u) noexcept: Xoshiro256pp(seed, 0u, 0u, 0u) {}
+    //! stream identified by three words as in Philox
+    Xoshiro256pp(uint64_t seed, uint32_t c1, uint32_t c2, uint32_t c3) noexcept {
+        uint64_t x = mix(seed);
+        x = mix(x ^ (static_cast<uint64_t>(c1) | (static_cast<uint64_t>(c2) << 32)));
+        x = mix(x ^ c3);
+        for (auto& s: state_) s = splitmix64(&x);
+    }
+    //! set the state directly; must not be all zero
+    explicit Xoshiro256pp(const state_type& state) noexcept: state_(state) {}
+
+    //! generate a random number
+    result_type operator()() noexcept {
+        const uint64_t result = rotl(state_[0u] + state_[3u], 23) + state_[0u];
+        const uint64_t t = state_[1u] << 17;
+        state_[2u] ^= state_[0u];
+        state_[3u] ^= state_[1u];
+        state_[1u] ^= state_[2u];
+        state_[0u] ^= state_[3u];
+        state_[2u] ^= t;
+        state_[3u] = rotl(state_[3u], 45);
+        return result;
+    }
+    //! fill `n` outputs; the same as calling operator() `n` times
+    void generate(result_type* first, size_t n) noexcept {
+        for (size_t i=0u; i<n; ++i) first[i] = (*this)();
+    }
+    //! skip z outputs
+    void discard(unsigned long long z) noexcept {
+        for (; z>0u; --z) (*this)();
+    }
+    //! minimum value
+    static constexpr result_type min() noexcept {return 0u;}
+    //! maximum value
+    static constexpr result_type max() noexcept {return std::numeric_limits<result_type>::max();}
+    //! name of the algorithm
+    static const char* name() noexcept {return "xoshiro256++";}
+
+  private:
+    //! rotate left
+    static uint64_t rotl(uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+    //! finalizer of SplitMix64
+    static uint64_t mix(uint64_t z) noexcept {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+        return z ^ (z >> 31);
+    }
+    //! SplitMix64
+    static uint64_t splitmix64(uint64_t* x) noexcept {
+        return mix(*x += 0x9E3779B97F4A7C15u);
+    }
+
+    //! state
+    state_type state_;
+};
+
+} // namespace pbf
+
+#endif /* PBT_XOSHIRO_HPP_ */
@@ -0,0 +1,33 @@
+#include "alias_table.hpp"
+
+#include <iostream>
+#include <random>
+#include <cmath>
+
+int main() {
+    const std::vector<double> weights{1.0, 0.0, 3.0, 6.0};
+    pbf::AliasTable dist(weights);
+    std::mt19937_64 engine(42u);
+    const size_t n = 1000000u;
+    std::vector<size_t> counts(weights.size());
+    for (size_t i=0; i<n; ++i) {
+        ++counts[dist(engine)];
+    }
+    for (size_t i=0; i<weights.size(); ++i) {
+        const double expected = n * weights[i] / 10.0;
+        std::cout << i << "\t" << counts[i] << "\t" << expected << "\n";
+        if (std::abs(counts[i] - expected) > 5.0 * std::sqrt(expected + 1.0)) return 1;
+    }
+
+    pbf::AliasTables tables(weights.size());
+    tables.push_back({0.0, 0.0, 2.0, 0.0});
+    tables.push_back(weights);
+    if (tables.constant(0u) != 2u || tables.constant(1u) != pbf::AliasTables::NONE) return 1;
+    if (tables.weights(1u)[3u] != 0.6) return 1;
+    std::mt19937_64 engine_flat(42u), engine_single(42u);
+    for (size_t i=0; i<1000u; ++i) {
+        if (tables(0u, engine_flat) != 2u) return 1;
+        if (tables(1u, engine_flat) != dist(engine_single)) return 1;
+    }
+    return 0;
+}
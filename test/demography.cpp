@@ -0,0 +1,17 @@
+#include "demography.hpp"
+
+#include <iostream>
+#include <sstream>
+
+int main() {
+    pbf::Demography demography(2u, 3u);
+    demography.append(0, 3)[4] = 42u;
+    demography.append(1, 0)[0] = 7u;
+    std::stringstream buffer;
+    demography.write_binary(buffer);
+    const auto copy = pbf::Demography::read_binary(buffer);
+    copy.write(std::cout);
+    if (copy.num_times() != 2u || copy.year(1) != 1 || copy.season(1) != 0) return 1;
+    if (copy.counts(0, 1)[1] != 42u || copy.counts(1, 0)[0] != 7u) return 1;
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "pedigree.hpp"
+
+#include <iostream>
+
+int main() {
+    pbf::Pedigree pedigree;
+    const auto father = pedigree.emplace(true);
+    const auto mother = pedigree.emplace(false);
+    const auto child = pedigree.emplace(father, mother, 1, false);
+    if (pedigree.id(child) != 3u) return 1;
+    const auto ancestors = pedigree.collect_ancestors({child});
+    if (ancestors.size() != 2u || ancestors[0] != father) return 1;
+    pedigree.release(father);
+    pedigree.release(mother);
+    std::cout << "size: " << pedigree.size() << "\n";
+    if (pedigree.size() != 3u) return 1;
+    pedigree.release(child);
+    std::cout << "size: " << pedigree.size() << "\n";
+    if (pedigree.size() != 0u) return 1;
+
+    std::vector<pbf::Pedigree::handle_type> handles;
+    for (int i=0; i<4; ++i) handles.push_back(pedigree.emplace(i % 2 == 0));
+    const auto grandchild = pedigree.emplace(handles[2], handles[3], 2, true);
+    pedigree.release(handles[0]);
+    pedigree.release(handles[1]);
+    const auto moved = pedigree.compact();
+    const auto h = moved[grandchild];
+    std::cout << "compacted: " << grandchild << " -> " << h << "\n";
+    if (pedigree.num_vacant() != 0u || pedigree.size() != 3u || h >= grandchild) return 1;
+    if (pedigree.id(h) != 8u || pedigree.id(pedigree[h].mother()) != 7u) return 1;
+
+    // branches share frozen segments and count references separately
+    const auto child_h = pedigree.emplace(h, pedigree[h].mother(), 3, false);
+    auto branch = pedigree.fork();
+    const auto sibling = branch->emplace(h, pedigree[h].mother(), 3, true);
+    auto twig = branch->fork();
+    if (branch->num_frozen() != twig->num_frozen() || twig->num_frozen() <= pedigree.num_frozen()) return 1;
+    const auto bytes = pedigree.bytes();
+    branch->release(sibling);
+    branch->release(child_h);
+    branch->release(h);
+    branch->release(pedigree[h].father());
+    branch->release(pedigree[h].mother());
+    std::cout << "branch: " << branch->size() << " in use, "
+              << branch->num_frozen_vacant() << " frozen vacant\n";
+    if (branch->size() != 0u || branch->num_frozen_vacant() != 5u) return 1;
+    const auto thawed = branch->compact();
+    if (branch->num_frozen() != 0u || branch->size() != 0u || thawed[sibling] != 0u) return 1;
+    if (pedigree.size() != 4u || pedigree.bytes() != bytes) return 1;
+    if (twig->size() != 5u || twig->id(sibling) != 10u || twig->id((*twig)[sibling].father()) != 8u) return 1;
+    twig->release(child_h);
+    const auto moved_twig = twig->compact();
+    const auto s = moved_twig[sibling];
+    if (twig->num_frozen() != 0u || twig->size() != 4u || twig->id(s) != 10u) return 1;
+    if (twig->id((*twig)[s].mother()) != 7u) return 1;
+    return 0;
+}
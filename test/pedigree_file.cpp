@@ -0,0 +1,45 @@
+#include "pedigree_file.hpp"
+
+#include <unistd.h>
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+//! write columns to `path` and check reading them
+bool is_readable(const std::string& path) {
+    {
+        pbf::PedigreeColumns columns;
+        columns.push_back(5u, 1u, 2u, 3, 0, 9);
+        columns.push_back(2u, 0u, 0u, -4);
+        columns.push_back(1u, 0u, 0u, -4);
+        std::ofstream ofs(path, std::ios::binary);
+        columns.write(ofs);
+    }
+    pbf::PedigreeFile file(path);
+    std::cout << "size: " << file.size() << "\n";
+    if (file.size() != 3u || file.id(0u) != 1u) return false;
+    const auto row = file.find(5u);
+    if (row != 2u || file.father_id(row) != 1u || file.capture_year(row) != 9) return false;
+    if (file.location(file.find(file.mother_id(row))) != -1) return false;
+    if (file.find(3u) != file.size()) return false;
+    return true;
+}
+
+int main() {
+    // unique name in TMPDIR so that parallel runs do not collide
+    const char* tmpdir = std::getenv("TMPDIR");
+    std::string pattern = std::string((tmpdir && *tmpdir) ? tmpdir : "/tmp") + "/test_pedigree_file_XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+    const int fd = ::mkstemp(buffer.data());
+    if (fd < 0) return 1;
+    ::close(fd);
+    const std::string path(buffer.data());
+    const bool passed = is_readable(path);
+    std::remove(path.c_str());
+    return passed ? 0 : 1;
+}
@@ -1,10 +1,231 @@
 #include "population.hpp"
+#include "context.hpp"
+#include "demography.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <sstream>
 #include <random>
+#include <string>
+#include <vector>
+
+//! demography and sample_family of a run
+std::string simulate(std::shared_ptr<const pbf::Context> context, const pbf::PopulationParams& params) {
+    pbf::Population pop(4000u, 42u, context, params);
+    pop.run(20, {10u, 10u}, {10u, 10u}, 15);
+    std::ostringstream oss;
+    pop.write_demography(oss);
+    pop.write_sample_family(oss);
+    return oss.str();
+}
+
+//! census of each age but 0 matches the individuals at the end of every year
+bool is_census_consistent(const pbf::PopulationParams& params) {
+    pbf::Population pop(200u, 42u, nullptr, params);
+    std::vector<uint64_t> census;
+    pop.set_demography_sink([&census](const pbf::Demography& x) {
+        census.assign(x.num_ages(), 0u);
+        for (size_t loc=0u; loc<x.num_locations(); ++loc) {
+            for (size_t age=0u; age<x.num_ages(); ++age) census[age] += x.counts(0u, loc)[age];
+        }
+    });
+    bool is_consistent = true;
+    uint64_t num_adults = 0u;
+    pop.run(20, {5u, 5u}, {5u, 5u}, 15, -1, [&](const pbf::Population& x) {
+        // juveniles are counted twice in census; see Population::append_demography()
+        std::vector<uint64_t> observed(census.size());
+        std::stringstream individuals;
+        x.write(individuals);
+        uint64_t handle, father, mother;
+        int64_t birth_year;
+        while (individuals >> handle >> father >> mother >> birth_year) {
+            ++observed[static_cast<size_t>(x.year() - birth_year)];
+        }
+        for (size_t age=1u; age<census.size(); ++age) {
+            if (observed[age] != census[age]) is_consistent = false;
+            num_adults += observed[age];
+        }
+    });
+    return is_consistent && num_adults > 0u;
+}
+
+//! rows of write_sample_family() split into 6 columns without header
+std::vector<std::vector<std::string>> read_sample_family(const pbf::Population& pop) {
+    std::stringstream content;
+    pop.write_sample_family(content);
+    std::vector<std::vector<std::string>> rows;
+    std::string line;
+    std::getline(content, line);
+    while (std::getline(content, line)) {
+        std::istringstream iss(line);
+        std::vector<std::string> row;
+        std::string field;
+        while (std::getline(iss, field, '\t')) row.push_back(field);
+        row.resize(6u);
+        rows.push_back(std::move(row));
+    }
+    return rows;
+}
 
 int main() {
     pbf::Population pop(1000u, std::random_device{}());
     pop.run(10u);
+
+    const uint64_t seed = 42u;
+    pbf::Population original(1000u, seed);
+    std::stringstream checkpoint;
+    original.run(20, {1u, 1u}, {1u, 1u}, 12, -1, [&checkpoint](const pbf::Population& x) {
+        if (x.year() == 5) x.write_checkpoint(checkpoint);
+    });
+    pbf::Population restored(checkpoint, seed);
+    if (restored.year() != 5) return 1;
+    restored.run(20, {1u, 1u}, {1u, 1u}, 12);
+    std::ostringstream expected, observed;
+    original.write_sample_family(expected);
+    restored.write_sample_family(observed);
+    std::cout << "sample_family: " << expected.str().size() << " bytes\n";
+    if (expected.str() != observed.str()) return 1;
+    original.write_demography(expected);
+    restored.write_demography(observed);
+    if (expected.str() != observed.str()) return 1;
+    // flags that change the state must match
+    pbf::PopulationParams eager;
+    eager.EAGER_JUVENILES = true;
+    checkpoint.clear();
+    checkpoint.seekg(0);
+    try {
+        pbf::Population mismatched(checkpoint, seed, eager);
+        return 1;
+    } catch (const std::runtime_error&) {}
+
+    // censuses streamed before the checkpoint are not restored,
+    // and those after it are the same as the original
+    auto stream_to = [](std::vector<std::string>* censuses) {
+        return [censuses](const pbf::Demography& x) {
+            std::ostringstream oss;
+            oss << x.year(0u) << "\n";
+            x.write(oss, false);
+            censuses->push_back(oss.str());
+        };
+    };
+    std::vector<std::string> streamed, restreamed;
+    pbf::Population streaming(1000u, seed);
+    streaming.set_demography_sink(stream_to(&streamed));
+    std::stringstream streamed_checkpoint;
+    streaming.run(20, {1u, 1u}, {1u, 1u}, 12, -1, [&streamed_checkpoint](const pbf::Population& x) {
+        if (x.year() == 5) x.write_checkpoint(streamed_checkpoint);
+    });
+    pbf::Population resumed(streamed_checkpoint, seed);
+    resumed.set_demography_sink(stream_to(&restreamed));
+    resumed.run(20, {1u, 1u}, {1u, 1u}, 12);
+    std::cout << "streamed censuses: " << streamed.size() << " -> " << restreamed.size() << "\n";
+    if (restreamed.empty() || restreamed.size() >= streamed.size()) return 1;
+    if (!std::equal(restreamed.begin(), restreamed.end(), streamed.end() - static_cast<ptrdiff_t>(restreamed.size()))) return 1;
+    if (std::stoi(restreamed.front()) != 6) return 1;
+
+    pbf::Population trunk(200u, seed);
+    trunk.run(5, {1u, 1u}, {1u, 1u}, 15);
+    auto branch = trunk.fork(seed);
+    auto other = trunk.fork(seed + 1u);
+    trunk.run(20, {1u, 1u}, {1u, 1u}, 15);
+    branch->run(20, {1u, 1u}, {1u, 1u}, 15);
+    other->run(20, {1u, 1u}, {1u, 1u}, 15);
+    std::ostringstream from_trunk, from_branch, from_other;
+    trunk.write_demography(from_trunk);
+    branch->write_demography(from_branch);
+    other->write_demography(from_other);
+    if (from_trunk.str() != from_branch.str()) return 1;
+    if (from_trunk.str() == from_other.str()) return 1;
+    from_trunk.str("");
+    from_branch.str("");
+    trunk.write_sample_family(from_trunk);
+    branch->write_sample_family(from_branch);
+    if (from_trunk.str() != from_branch.str()) return 1;
+    std::cout << "fork memory: " << trunk.memory_usage().total() << " "
+              << branch->memory_usage().total() << " bytes\n";
+    if (trunk.memory_usage().total() != branch->memory_usage().total()) return 1;
+
+    pbf::PopulationParams count_only;
+    count_only.COUNT_ONLY = true;
+    pbf::Population counts(200u, seed, nullptr, count_only);
+    counts.run(20, {0u, 0u}, {0u, 0u});
+    std::ostringstream census;
+    counts.write_demography(census);
+    std::cout << "count_only demography: " << census.str().size() << " bytes\n";
+    if (census.str().size() < 1000u) return 1;
+
+    pbf::PopulationParams cohort_survival;
+    cohort_survival.COHORT_SURVIVAL = true;
+    if (!is_census_consistent(pbf::PopulationParams{})) return 1;
+    if (!is_census_consistent(cohort_survival)) return 1;
+    pbf::PopulationParams cohort_migration;
+    cohort_migration.COHORT_MIGRATION = true;
+    if (!is_census_consistent(cohort_migration)) return 1;
+    cohort_migration.COHORT_SURVIVAL = true;
+    if (!is_census_consistent(cohort_migration)) return 1;
+
+    // ages with zero selectivity are never sampled
+    pbf::PopulationParams selective;
+    selective.SAMPLE_SELECTIVITY = {0.0, 0.0, 0.0, 1.0};
+    pbf::Population fished(200u, seed, nullptr, selective);
+    fished.run(20, {10u, 10u}, {0u, 0u}, 5);
+    size_t num_sampled = 0u;
+    for (const auto& row: read_sample_family(fished)) {
+        if (row[5u].empty()) continue;
+        ++num_sampled;
+        if (std::stoi(row[5u]) - std::stoi(row[3u]) < 3) return 1;
+    }
+    if (num_sampled == 0u) return 1;
+    // sampling gives up instead of looping forever
+    selective.SAMPLE_SELECTIVITY = {0.0};
+    pbf::Population unfished(200u, seed, nullptr, selective);
+    unfished.run(20, {10u, 10u}, {0u, 0u}, 5);
+    if (!read_sample_family(unfished).empty()) return 1;
+
+    // parents are recorded only for those born in or after year 20 - 3 - 2
+    pbf::Population shallow(200u, seed);
+    shallow.run(20, {10u, 10u}, {10u, 10u}, 3, 2);
+    size_t num_truncated = 0u, num_recorded = 0u;
+    for (const auto& row: read_sample_family(shallow)) {
+        const bool has_parents = (row[1u] != "0" || row[2u] != "0");
+        if (std::stoi(row[3u]) < 15) {
+            if (has_parents) return 1;
+            ++num_truncated;
+        } else {
+            if (!has_parents) return 1;
+            ++num_recorded;
+        }
+    }
+    if (num_truncated == 0u || num_recorded == 0u) return 1;
+
+    // results do not depend on the number of threads in any mode;
+    // K is large enough for several chunks per location
+    pbf::IndividualParams large;
+    large.CARRYING_CAPACITY = 40000.0;
+    const auto context = std::make_shared<const pbf::Context>(large);
+    for (int mode=0; mode<4; ++mode) {
+        pbf::PopulationParams params;
+        params.COHORT_SURVIVAL = (mode == 1);
+        params.COHORT_MIGRATION = (mode == 2);
+        params.COHORT_RECRUITMENT = (mode == 3);
+        const auto single = simulate(context, params);
+        params.NUM_THREADS = 4u;
+        const auto multi = simulate(context, params);
+        std::cout << "mode " << mode << ": " << single.size() << " bytes\n";
+        if (single != multi) return 1;
+    }
+
+    // juveniles kept as family records give the same counts and pedigree
+    // as those created at birth one by one
+    for (const bool by_cohort: {false, true}) {
+        pbf::PopulationParams params;
+        params.COHORT_RECRUITMENT = by_cohort;
+        params.COHORT_MIGRATION = by_cohort;
+        const auto families = simulate(context, params);
+        params.EAGER_JUVENILES = true;
+        const auto individuals = simulate(context, params);
+        std::cout << "families by_cohort=" << by_cohort << ": " << families.size() << " bytes\n";
+        if (families != individuals) return 1;
+    }
     return 0;
 }
@@ -0,0 +1,123 @@
+#include "random_fwd.hpp"
+#include "random.hpp"
+#include "philox.hpp"
+#include "xoshiro.hpp"
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+
+//! previous engine seeded with the key and counters as the others are
+struct MersenneTwister: std::mt19937_64 {
+    MersenneTwister(uint64_t key, uint32_t a, uint32_t b, uint32_t c)
+    : std::mt19937_64(seed(key, a, b, c)) {}
+    static std::mt19937_64::result_type seed(uint64_t key, uint32_t a, uint32_t b, uint32_t c) {
+        std::seed_seq sequence{static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32), a, b, c};
+        std::mt19937_64::result_type x;
+        sequence.generate(reinterpret_cast<uint32_t*>(&x), reinterpret_cast<uint32_t*>(&x) + 2);
+        return x;
+    }
+};
+
+//! bad engine: 64-bit LCG whose adjacent streams are correlated
+struct LinearCongruential {
+    using result_type = uint64_t;
+    LinearCongruential(uint64_t key, uint32_t a, uint32_t b, uint32_t c) noexcept
+    : state_(key ^ (uint64_t{a} << 32) ^ (uint64_t{b} << 16) ^ c) {}
+    static constexpr result_type min() {return 0u;}
+    static constexpr result_type max() {return ~result_type{0u};}
+    result_type operator()() noexcept {
+        return state_ = state_ * 6364136223846793005u + 1442695040888963407u;
+    }
+  private:
+    uint64_t state_;
+};
+
+//! chi-squared statistic below the mean + 6 sd
+bool is_uniform(const std::vector<size_t>& counts, const size_t n) {
+    const double expected = static_cast<double>(n) / static_cast<double>(counts.size());
+    double x = 0.0;
+    for (const auto c: counts) {
+        const double d = static_cast<double>(c) - expected;
+        x += d * d / expected;
+    }
+    const double df = static_cast<double>(counts.size() - 1u);
+    std::cerr << x << " (df " << df << ")\n";
+    return x < df + 6.0 * std::sqrt(2.0 * df);
+}
+
+//! each bit is set in half of `n` trials within 5 sd
+bool is_balanced(const std::vector<size_t>& counts, const size_t n) {
+    for (const auto c: counts) {
+        const double z = (static_cast<double>(c) - 0.5 * n) / std::sqrt(0.25 * n);
+        if (std::abs(z) > 5.0) return false;
+    }
+    return true;
+}
+
+//! the same distributional checks for any engine
+template <class Engine>
+bool passes(const char* name) {
+    std::cerr << name << "\n";
+    const size_t n = 1000000u;
+    Engine engine(42u, 1u, 2u, 3u);
+    std::vector<size_t> counts(64u);
+    for (size_t i=0; i<n; ++i) {
+        const uint64_t x = engine();
+        for (unsigned bit=0u; bit<64u; ++bit) counts[bit] += (x >> bit) & 1u;
+    }
+    if (!is_balanced(counts, n)) return false;
+    counts.assign(100u, 0u);
+    for (size_t i=0; i<n; ++i) {
+        const double x = pbf::canonical(engine);
+        if (x < 0.0 || x >= 1.0) return false;
+        ++counts[static_cast<size_t>(x * 100.0)];
+    }
+    if (!is_uniform(counts, n)) return false;
+    counts.assign(37u, 0u);
+    for (size_t i=0; i<n; ++i) ++counts[pbf::bounded(engine, 37u)];
+    if (!is_uniform(counts, n)) return false;
+    // rejection is frequent near 2^63; bins are equal except for the last one by < 48
+    const uint64_t huge = (uint64_t(3u) << 62) + 1u;
+    const uint64_t width = huge / 48u + 1u;
+    counts.assign(48u, 0u);
+    for (size_t i=0; i<n; ++i) {
+        const uint64_t x = pbf::bounded(engine, huge);
+        if (x >= huge) return false;
+        ++counts[x / width];
+    }
+    if (!is_uniform(counts, n)) return false;
+    // adjacent streams are not correlated
+    counts.assign(64u, 0u);
+    const size_t num_streams = 100000u;
+    for (uint32_t i=0; i<num_streams; ++i) {
+        Engine a(42u, i, 0u, 0u), b(42u, i + 1u, 0u, 0u);
+        const uint64_t x = a() ^ b();
+        for (unsigned bit=0u; bit<64u; ++bit) counts[bit] += (x >> bit) & 1u;
+    }
+    return is_balanced(counts, num_streams);
+}
+
+int main() {
+    // Reference implementation by Blackman and Vigna
+    pbf::Xoshiro256pp xoshiro(pbf::Xoshiro256pp::state_type{{1u, 2u, 3u, 4u}});
+    if (xoshiro() != 0x2800001u) return 1;
+    if (xoshiro() != 0x3800067u) return 1;
+    if (xoshiro() != 0xcc00003800067u) return 1;
+    pbf::Xoshiro256pp sequential(7u, 1u, 2u, 3u), bulk(7u, 1u, 2u, 3u);
+    std::vector<uint64_t> buffer(37u);
+    bulk.generate(buffer.data(), buffer.size());
+    for (const auto x: buffer) {
+        if (x != sequential()) return 1;
+    }
+
+    // Both engines selectable by TEKKA_RNG pass the same checks
+    std::cerr << "URBG: " << pbf::URBG::name() << "\n";
+    if (!passes<pbf::Philox>("philox")) return 1;
+    if (!passes<pbf::Xoshiro256pp>("xoshiro")) return 1;
+    // the checks accept the previous engine and reject a bad one
+    if (!passes<MersenneTwister>("mt19937_64")) return 1;
+    if (passes<LinearCongruential>("lcg")) return 1;
+    return 0;
+}